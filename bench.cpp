@@ -0,0 +1,224 @@
+#include "big_integer.h"
+#include "ci-extra/big_integer_gmp.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+// Every benchmark runs for big_integer and for the GMP-backed big_integer_gmp on the same values. Sizes count
+// big_integer limbs; the Time column is ns per operation and limbs/s is the throughput in those limbs.
+namespace {
+
+constexpr int LIMB_BITS = sizeof(big_integer::limb) * 8;
+constexpr int64_t MAX_LIMBS = int64_t(1) << 20;
+// Division and decimal conversion are quasi-linear with large constants, a 2^20-limb run would take minutes.
+constexpr int64_t SLOW_MAX_LIMBS = int64_t(1) << 16;
+
+// A random non-negative value of exactly n limbs, built by halves so that it takes O(M(n) log n) for either type.
+template <typename T>
+T random_value(int64_t n, std::mt19937_64& rng) {
+  if (n == 1) {
+    T value(static_cast<int>(rng() >> 49) | 1 << 15);
+    for (int i = 16; i < LIMB_BITS; i += 16) {
+      value <<= 16;
+      value += T(static_cast<int>(rng() >> 48));
+    }
+    return value;
+  }
+  int64_t low = n / 2;
+  T value = random_value<T>(n - low, rng);
+  value <<= static_cast<int>(low * LIMB_BITS);
+  value += random_value<T>(low, rng);
+  return value;
+}
+
+template <typename T>
+T random_value(int64_t n) {
+  std::mt19937_64 rng(n);
+  return random_value<T>(n, rng);
+}
+
+void set_throughput(benchmark::State& state) {
+  state.counters["limbs/s"] = benchmark::Counter(static_cast<double>(state.range(0)),
+                                                 benchmark::Counter::kIsIterationInvariantRate);
+}
+
+template <typename T, typename F>
+void binary_operation(benchmark::State& state, int64_t a_limbs, int64_t b_limbs, const F& f) {
+  T a = random_value<T>(a_limbs);
+  T b = random_value<T>(b_limbs);
+  for (auto _ : state) {
+    T result = f(a, b);
+    benchmark::DoNotOptimize(result);
+  }
+  set_throughput(state);
+}
+
+template <typename T, typename F>
+void unary_operation(benchmark::State& state, const F& f) {
+  T value = random_value<T>(state.range(0));
+  for (auto _ : state) {
+    T result = f(value);
+    benchmark::DoNotOptimize(result);
+  }
+  set_throughput(state);
+}
+
+template <typename T>
+void BM_from_string(benchmark::State& state) {
+  std::string str = to_string(random_value<T>(state.range(0)));
+  for (auto _ : state) {
+    T value(str);
+    benchmark::DoNotOptimize(value);
+  }
+  set_throughput(state);
+}
+
+template <typename T>
+void BM_to_string(benchmark::State& state) {
+  T value = random_value<T>(state.range(0));
+  for (auto _ : state) {
+    std::string str = to_string(value);
+    benchmark::DoNotOptimize(str);
+  }
+  set_throughput(state);
+}
+
+template <typename T>
+void BM_add(benchmark::State& state) {
+  binary_operation<T>(state, state.range(0), state.range(0), [](const T& a, const T& b) { return a + b; });
+}
+
+template <typename T>
+void BM_sub(benchmark::State& state) {
+  binary_operation<T>(state, state.range(0), state.range(0), [](const T& a, const T& b) { return a - b; });
+}
+
+template <typename T>
+void BM_mul(benchmark::State& state) {
+  binary_operation<T>(state, state.range(0), state.range(0), [](const T& a, const T& b) { return a * b; });
+}
+
+template <typename T>
+void BM_div(benchmark::State& state) {
+  binary_operation<T>(state, 2 * state.range(0), state.range(0), [](const T& a, const T& b) { return a / b; });
+}
+
+template <typename T>
+void BM_mod(benchmark::State& state) {
+  binary_operation<T>(state, 2 * state.range(0), state.range(0), [](const T& a, const T& b) { return a % b; });
+}
+
+template <typename T>
+void BM_and(benchmark::State& state) {
+  binary_operation<T>(state, state.range(0), state.range(0), [](const T& a, const T& b) { return a & b; });
+}
+
+template <typename T>
+void BM_or(benchmark::State& state) {
+  binary_operation<T>(state, state.range(0), state.range(0), [](const T& a, const T& b) { return a | b; });
+}
+
+template <typename T>
+void BM_xor(benchmark::State& state) {
+  binary_operation<T>(state, state.range(0), state.range(0), [](const T& a, const T& b) { return a ^ b; });
+}
+
+template <typename T>
+void BM_shl(benchmark::State& state) {
+  unary_operation<T>(state, [](const T& a) { return a << 77; });
+}
+
+template <typename T>
+void BM_shr(benchmark::State& state) {
+  unary_operation<T>(state, [](const T& a) { return a >> 77; });
+}
+
+template <typename T>
+void BM_neg(benchmark::State& state) {
+  unary_operation<T>(state, [](const T& a) { return -a; });
+}
+
+template <typename T>
+void BM_not(benchmark::State& state) {
+  unary_operation<T>(state, [](const T& a) { return ~a; });
+}
+
+template <typename T>
+void BM_increment(benchmark::State& state) {
+  T value = random_value<T>(state.range(0));
+  for (auto _ : state) {
+    ++value;
+    benchmark::DoNotOptimize(value);
+  }
+  set_throughput(state);
+}
+
+template <typename T>
+void BM_decrement(benchmark::State& state) {
+  T value = random_value<T>(state.range(0));
+  for (auto _ : state) {
+    --value;
+    benchmark::DoNotOptimize(value);
+  }
+  set_throughput(state);
+}
+
+// The operands are equal values in separate buffers, so a comparison has to look at every limb.
+template <typename T, typename F>
+void comparison(benchmark::State& state, const F& f) {
+  T a = random_value<T>(state.range(0));
+  T b = a;
+  for (auto _ : state) {
+    bool result = f(a, b);
+    benchmark::DoNotOptimize(result);
+  }
+  set_throughput(state);
+}
+
+template <typename T>
+void BM_less(benchmark::State& state) {
+  comparison<T>(state, [](const T& a, const T& b) { return a < b; });
+}
+
+template <typename T>
+void BM_equal(benchmark::State& state) {
+  comparison<T>(state, [](const T& a, const T& b) { return a == b; });
+}
+
+void sizes(benchmark::internal::Benchmark* bench) {
+  bench->RangeMultiplier(16)->Range(1, MAX_LIMBS);
+}
+
+void slow_sizes(benchmark::internal::Benchmark* bench) {
+  bench->RangeMultiplier(16)->Range(1, SLOW_MAX_LIMBS);
+}
+
+} // namespace
+
+#define BIG_INTEGER_BENCHMARK(name, range)                                                                           \
+  BENCHMARK_TEMPLATE(name, big_integer)->Apply(range);                                                               \
+  BENCHMARK_TEMPLATE(name, big_integer_gmp)->Apply(range)
+
+BIG_INTEGER_BENCHMARK(BM_from_string, slow_sizes);
+BIG_INTEGER_BENCHMARK(BM_to_string, slow_sizes);
+BIG_INTEGER_BENCHMARK(BM_add, sizes);
+BIG_INTEGER_BENCHMARK(BM_sub, sizes);
+BIG_INTEGER_BENCHMARK(BM_mul, sizes);
+BIG_INTEGER_BENCHMARK(BM_div, slow_sizes);
+BIG_INTEGER_BENCHMARK(BM_mod, slow_sizes);
+BIG_INTEGER_BENCHMARK(BM_and, sizes);
+BIG_INTEGER_BENCHMARK(BM_or, sizes);
+BIG_INTEGER_BENCHMARK(BM_xor, sizes);
+BIG_INTEGER_BENCHMARK(BM_shl, sizes);
+BIG_INTEGER_BENCHMARK(BM_shr, sizes);
+BIG_INTEGER_BENCHMARK(BM_neg, sizes);
+BIG_INTEGER_BENCHMARK(BM_not, sizes);
+BIG_INTEGER_BENCHMARK(BM_increment, sizes);
+BIG_INTEGER_BENCHMARK(BM_decrement, sizes);
+BIG_INTEGER_BENCHMARK(BM_less, sizes);
+BIG_INTEGER_BENCHMARK(BM_equal, sizes);
+
+BENCHMARK_MAIN();
@@ -1,34 +1,1898 @@
 #include "big_integer.h"
 
 #include <algorithm>
+#include <array>
 #include <bit>
+#include <cctype>
 #include <cmath>
 #include <cstddef>
+#include <cstdlib>
 #include <cstring>
 #include <functional>
 #include <iostream>
+#include <limits>
+#include <numeric>
 #include <ostream>
 #include <stdexcept>
+#include <string_view>
 #include <utility>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define BIG_INTEGER_X86_KERNELS
+#endif
 
 namespace loc_consts {
-constexpr uint32_t CHUNK_SIZE = 32;
-constexpr uint32_t CHUNK_SIZE_LOG2 = 5;
-constexpr uint64_t BETTA = 4'294'967'296;
-constexpr unsigned long BASE = 10;
-constexpr unsigned long TRANSITION_CHUNK_SIZE = 9;
-constexpr unsigned long TRANSITION_CHUNK = 1'000'000'000;
-
-constexpr uint32_t CHUNK_MAX = std::numeric_limits<uint32_t>().max();
+constexpr uint32_t CHUNK_SIZE = std::numeric_limits<big_integer::limb>().digits;
+
+constexpr big_integer::limb CHUNK_MAX = std::numeric_limits<big_integer::limb>().max();
 constexpr uint64_t DOUBLE_CHUNK_MAX = std::numeric_limits<uint64_t>().max();
 constexpr int64_t SIGNED_DOUBLE_CHUNK_MIN = std::numeric_limits<int64_t>().min();
 constexpr int64_t SIGNED_DOUBLE_CHUNK_MAX = std::numeric_limits<int64_t>().max();
+
+constexpr size_t KARATSUBA_THRESHOLD = 32;
+constexpr size_t SQR_KARATSUBA_THRESHOLD = 48;
+constexpr size_t TOOM_THRESHOLD = 400;
+constexpr size_t NTT_THRESHOLD = 8000;
+constexpr size_t NTT_MAX_LENGTH = size_t(1) << 24; // in 32-bit coefficients
+constexpr size_t NTT_ROOTS_CACHE = size_t(1) << 17; // in 32-bit coefficients
+constexpr size_t DIV_THRESHOLD = 60;
+constexpr size_t DIV_STACK_LIMBS = 1024;
+constexpr size_t BARRETT_SHORT_THRESHOLD = 200;
+constexpr size_t HGCD_THRESHOLD = 200;
+constexpr size_t GCD_HGCD_THRESHOLD = 800;
+constexpr size_t TO_STRING_THRESHOLD = 60;
+constexpr size_t FROM_STRING_THRESHOLD = 60;
+constexpr size_t RADIX_CACHE_LIMBS = 4096;
+constexpr unsigned MAX_BASE = 36;
 } // namespace loc_consts
 
+// Kernels working on raw little-endian limb spans. Unless stated otherwise, the output must not overlap the inputs.
+namespace loc_kernels {
+using limb = big_integer::limb;
+#ifdef BIG_INTEGER_64BIT_LIMBS
+__extension__ using double_limb = unsigned __int128;
+#else
+using double_limb = uint64_t;
+#endif
+
+limb add_n_generic(limb* r, const limb* a, const limb* b, size_t n) {
+  double_limb carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    carry += static_cast<double_limb>(a[i]) + b[i];
+    r[i] = static_cast<limb>(carry);
+    carry >>= loc_consts::CHUNK_SIZE;
+  }
+  return static_cast<limb>(carry);
+}
+
+limb sub_n_generic(limb* r, const limb* a, const limb* b, size_t n) {
+  limb borrow = 0;
+  for (size_t i = 0; i < n; ++i) {
+    double_limb res = static_cast<double_limb>(a[i]) - b[i] - borrow;
+    r[i] = static_cast<limb>(res);
+    borrow = static_cast<limb>(res >> loc_consts::CHUNK_SIZE) & 1;
+  }
+  return borrow;
+}
+
+// r += a * m, returns the carry out of the n limbs.
+limb addmul_1_generic(limb* r, const limb* a, size_t n, limb m) {
+  double_limb carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    carry += static_cast<double_limb>(a[i]) * m + r[i];
+    r[i] = static_cast<limb>(carry);
+    carry >>= loc_consts::CHUNK_SIZE;
+  }
+  return static_cast<limb>(carry);
+}
+
+// r -= a * m, returns the borrow out of the n limbs.
+limb submul_1_generic(limb* r, const limb* a, size_t n, limb m) {
+  double_limb carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    carry += static_cast<double_limb>(a[i]) * m;
+    auto low = static_cast<limb>(carry);
+    carry >>= loc_consts::CHUNK_SIZE;
+    carry += r[i] < low;
+    r[i] -= low;
+  }
+  return static_cast<limb>(carry);
+}
+
+// r = a * m, returns the carry out of the n limbs. r may coincide with a.
+limb mul_1_generic(limb* r, const limb* a, size_t n, limb m) {
+  double_limb carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    carry += static_cast<double_limb>(a[i]) * m;
+    r[i] = static_cast<limb>(carry);
+    carry >>= loc_consts::CHUNK_SIZE;
+  }
+  return static_cast<limb>(carry);
+}
+
+// r = a << shift for 0 < shift < CHUNK_SIZE, returns the bits shifted out. r may coincide with a or lie above it.
+limb lshift_generic(limb* r, const limb* a, size_t n, unsigned shift) {
+  limb out = a[n - 1] >> (loc_consts::CHUNK_SIZE - shift);
+  for (size_t i = n - 1; i > 0; --i) {
+    r[i] = (a[i] << shift) | (a[i - 1] >> (loc_consts::CHUNK_SIZE - shift));
+  }
+  r[0] = a[0] << shift;
+  return out;
+}
+
+// r = a >> shift for 0 < shift < CHUNK_SIZE, r may coincide with a or lie below it.
+void rshift_generic(limb* r, const limb* a, size_t n, unsigned shift) {
+  for (size_t i = 0; i + 1 < n; ++i) {
+    r[i] = (a[i] >> shift) | (a[i + 1] << (loc_consts::CHUNK_SIZE - shift));
+  }
+  r[n - 1] = a[n - 1] >> shift;
+}
+
+// r = f(a ^ a_mask, b ^ b_mask) ^ r_mask limb-wise, r may coincide with a or b. The masks are 0 or all ones,
+// so the same pass also serves operands and results kept as bitwise complements.
+template <typename F>
+void bitwise_n_generic(limb* r, const limb* a, const limb* b, size_t n, limb a_mask, limb b_mask, limb r_mask) {
+  for (size_t i = 0; i < n; ++i) {
+    r[i] = F()(a[i] ^ a_mask, b[i] ^ b_mask) ^ r_mask;
+  }
+}
+
+#ifdef BIG_INTEGER_X86_KERNELS
+// The carry-chain kernels below run over 64-bit words, i.e. two limbs at a time when limbs are 32-bit, and finish
+// an odd trailing limb in C++. The loops are written in assembly because compilers spill the carry flag to
+// a register on every step when given _addcarry_u64; lea and jrcxz keep the flags intact between iterations.
+constexpr size_t WORD_LIMBS = 64 / loc_consts::CHUNK_SIZE;
+
+limb add_n_adx(limb* r, const limb* a, const limb* b, size_t n) {
+  size_t words = n / WORD_LIMBS * WORD_LIMBS;
+  auto i = -static_cast<ptrdiff_t>(words / WORD_LIMBS);
+  unsigned long long carry;
+  asm volatile("xorl %k[carry], %k[carry]\n"
+               "1:\n\t"
+               "jrcxz 2f\n\t"
+               "movq (%[a],%[i],8), %[carry]\n\t"
+               "adcq (%[b],%[i],8), %[carry]\n\t"
+               "movq %[carry], (%[r],%[i],8)\n\t"
+               "leaq 1(%[i]), %[i]\n\t"
+               "jmp 1b\n"
+               "2:\n\t"
+               "movl $0, %k[carry]\n\t"
+               "adcl $0, %k[carry]"
+               : [i] "+c"(i), [carry] "=&r"(carry)
+               : [r] "r"(r + words), [a] "r"(a + words), [b] "r"(b + words)
+               : "cc", "memory");
+  if (words < n) {
+    uint64_t sum = static_cast<uint64_t>(a[words]) + b[words] + carry;
+    r[words] = static_cast<limb>(sum);
+    carry = sum >> (loc_consts::CHUNK_SIZE % 64);
+  }
+  return static_cast<limb>(carry);
+}
+
+limb sub_n_adx(limb* r, const limb* a, const limb* b, size_t n) {
+  size_t words = n / WORD_LIMBS * WORD_LIMBS;
+  auto i = -static_cast<ptrdiff_t>(words / WORD_LIMBS);
+  unsigned long long borrow;
+  asm volatile("xorl %k[borrow], %k[borrow]\n"
+               "1:\n\t"
+               "jrcxz 2f\n\t"
+               "movq (%[a],%[i],8), %[borrow]\n\t"
+               "sbbq (%[b],%[i],8), %[borrow]\n\t"
+               "movq %[borrow], (%[r],%[i],8)\n\t"
+               "leaq 1(%[i]), %[i]\n\t"
+               "jmp 1b\n"
+               "2:\n\t"
+               "movl $0, %k[borrow]\n\t"
+               "adcl $0, %k[borrow]"
+               : [i] "+c"(i), [borrow] "=&r"(borrow)
+               : [r] "r"(r + words), [a] "r"(a + words), [b] "r"(b + words)
+               : "cc", "memory");
+  if (words < n) {
+    uint64_t diff = static_cast<uint64_t>(a[words]) - b[words] - borrow;
+    r[words] = static_cast<limb>(diff);
+    borrow = (diff >> (loc_consts::CHUNK_SIZE % 64)) & 1;
+  }
+  return static_cast<limb>(borrow);
+}
+
+// Two independent carry chains: adcx folds in the high half of the previous product, adox adds r.
+limb addmul_1_adx(limb* r, const limb* a, size_t n, limb m) {
+  size_t words = n / WORD_LIMBS * WORD_LIMBS;
+  auto i = -static_cast<ptrdiff_t>(words / WORD_LIMBS);
+  unsigned long long carry = 0, low, high;
+  asm volatile("xorl %k[low], %k[low]\n"
+               "1:\n\t"
+               "jrcxz 2f\n\t"
+               "mulxq (%[a],%[i],8), %[low], %[high]\n\t"
+               "adcxq %[carry], %[low]\n\t"
+               "adoxq (%[r],%[i],8), %[low]\n\t"
+               "movq %[low], (%[r],%[i],8)\n\t"
+               "movq %[high], %[carry]\n\t"
+               "leaq 1(%[i]), %[i]\n\t"
+               "jmp 1b\n"
+               "2:\n\t"
+               "movl $0, %k[low]\n\t"
+               "adcxq %[low], %[carry]\n\t"
+               "adoxq %[low], %[carry]"
+               : [i] "+c"(i), [carry] "+&r"(carry), [low] "=&r"(low), [high] "=&r"(high)
+               : [r] "r"(r + words), [a] "r"(a + words), "d"(static_cast<unsigned long long>(m))
+               : "cc", "memory");
+  if (words < n) {
+    carry += static_cast<uint64_t>(a[words]) * m + r[words];
+    r[words] = static_cast<limb>(carry);
+    carry >>= loc_consts::CHUNK_SIZE % 64;
+  }
+  return static_cast<limb>(carry);
+}
+
+// r - x - borrow is computed as r + ~x + !borrow, so the subtraction becomes an adcx chain next to the adox one.
+limb submul_1_adx(limb* r, const limb* a, size_t n, limb m) {
+  size_t words = n / WORD_LIMBS * WORD_LIMBS;
+  auto i = -static_cast<ptrdiff_t>(words / WORD_LIMBS);
+  unsigned long long carry = 0, low, high;
+  asm volatile("xorl %k[low], %k[low]\n\t"
+               "stc\n"
+               "1:\n\t"
+               "jrcxz 2f\n\t"
+               "mulxq (%[a],%[i],8), %[low], %[high]\n\t"
+               "adoxq %[carry], %[low]\n\t"
+               "notq %[low]\n\t"
+               "adcxq (%[r],%[i],8), %[low]\n\t"
+               "movq %[low], (%[r],%[i],8)\n\t"
+               "movq %[high], %[carry]\n\t"
+               "leaq 1(%[i]), %[i]\n\t"
+               "jmp 1b\n"
+               "2:\n\t"
+               "movl $0, %k[low]\n\t"
+               "adoxq %[low], %[carry]\n\t"
+               "sbbq $-1, %[carry]"
+               : [i] "+c"(i), [carry] "+&r"(carry), [low] "=&r"(low), [high] "=&r"(high)
+               : [r] "r"(r + words), [a] "r"(a + words), "d"(static_cast<unsigned long long>(m))
+               : "cc", "memory");
+  if (words < n) {
+    carry += static_cast<uint64_t>(a[words]) * m;
+    auto product = static_cast<limb>(carry);
+    carry >>= loc_consts::CHUNK_SIZE % 64;
+    carry += r[words] < product;
+    r[words] -= product;
+  }
+  return static_cast<limb>(carry);
+}
+
+limb mul_1_adx(limb* r, const limb* a, size_t n, limb m) {
+  size_t words = n / WORD_LIMBS * WORD_LIMBS;
+  auto i = -static_cast<ptrdiff_t>(words / WORD_LIMBS);
+  unsigned long long carry = 0, low, high;
+  asm volatile("xorl %k[low], %k[low]\n"
+               "1:\n\t"
+               "jrcxz 2f\n\t"
+               "mulxq (%[a],%[i],8), %[low], %[high]\n\t"
+               "adcxq %[carry], %[low]\n\t"
+               "movq %[low], (%[r],%[i],8)\n\t"
+               "movq %[high], %[carry]\n\t"
+               "leaq 1(%[i]), %[i]\n\t"
+               "jmp 1b\n"
+               "2:\n\t"
+               "movl $0, %k[low]\n\t"
+               "adcxq %[low], %[carry]"
+               : [i] "+c"(i), [carry] "+&r"(carry), [low] "=&r"(low), [high] "=&r"(high)
+               : [r] "r"(r + words), [a] "r"(a + words), "d"(static_cast<unsigned long long>(m))
+               : "cc", "memory");
+  if (words < n) {
+    carry += static_cast<uint64_t>(a[words]) * m;
+    r[words] = static_cast<limb>(carry);
+    carry >>= loc_consts::CHUNK_SIZE % 64;
+  }
+  return static_cast<limb>(carry);
+}
+
+// Funnel shifts: each vector of limbs is combined with the same vector loaded one limb lower (or higher).
+// The direction of the loop is the same as in the generic kernels, so the same overlaps are allowed.
+__attribute__((target("avx2"))) limb lshift_avx2(limb* r, const limb* a, size_t n, unsigned shift) {
+  constexpr size_t STEP = sizeof(__m256i) / sizeof(limb);
+  limb out = a[n - 1] >> (loc_consts::CHUNK_SIZE - shift);
+  __m128i left = _mm_cvtsi32_si128(static_cast<int>(shift));
+  __m128i right = _mm_cvtsi32_si128(static_cast<int>(loc_consts::CHUNK_SIZE - shift));
+  size_t i = n;
+  for (; i > STEP; i -= STEP) {
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i - STEP));
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i - STEP - 1));
+    if constexpr (sizeof(limb) == 4) {
+      high = _mm256_or_si256(_mm256_sll_epi32(high, left), _mm256_srl_epi32(low, right));
+    } else {
+      high = _mm256_or_si256(_mm256_sll_epi64(high, left), _mm256_srl_epi64(low, right));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i - STEP), high);
+  }
+  lshift_generic(r, a, i, shift);
+  return out;
+}
+
+__attribute__((target("avx2"))) void rshift_avx2(limb* r, const limb* a, size_t n, unsigned shift) {
+  constexpr size_t STEP = sizeof(__m256i) / sizeof(limb);
+  __m128i right = _mm_cvtsi32_si128(static_cast<int>(shift));
+  __m128i left = _mm_cvtsi32_si128(static_cast<int>(loc_consts::CHUNK_SIZE - shift));
+  size_t i = 0;
+  for (; i + STEP < n; i += STEP) {
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + 1));
+    if constexpr (sizeof(limb) == 4) {
+      low = _mm256_or_si256(_mm256_srl_epi32(low, right), _mm256_sll_epi32(high, left));
+    } else {
+      low = _mm256_or_si256(_mm256_srl_epi64(low, right), _mm256_sll_epi64(high, left));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), low);
+  }
+  rshift_generic(r + i, a + i, n - i, shift);
+}
+
+template <typename F>
+__attribute__((target("avx2"))) void bitwise_n_avx2(limb* r, const limb* a, const limb* b, size_t n, limb a_mask,
+                                                   limb b_mask, limb r_mask) {
+  constexpr size_t STEP = sizeof(__m256i) / sizeof(limb);
+  // The masks are 0 or all ones, so their low 32 bits broadcast to the whole vector.
+  __m256i masks[] = {_mm256_set1_epi32(static_cast<int>(a_mask)), _mm256_set1_epi32(static_cast<int>(b_mask)),
+                     _mm256_set1_epi32(static_cast<int>(r_mask))};
+  size_t i = 0;
+  for (; i + STEP <= n; i += STEP) {
+    __m256i x = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)), masks[0]);
+    __m256i y = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)), masks[1]);
+    if constexpr (std::is_same_v<F, std::bit_and<>>) {
+      x = _mm256_and_si256(x, y);
+    } else if constexpr (std::is_same_v<F, std::bit_or<>>) {
+      x = _mm256_or_si256(x, y);
+    } else {
+      x = _mm256_xor_si256(x, y);
+    }
+    x = _mm256_xor_si256(x, masks[2]);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), x);
+  }
+  bitwise_n_generic<F>(r + i, a + i, b + i, n - i, a_mask, b_mask, r_mask);
+}
+
+template <typename F>
+__attribute__((target("avx512f"))) void bitwise_n_avx512(limb* r, const limb* a, const limb* b, size_t n, limb a_mask,
+                                                        limb b_mask, limb r_mask) {
+  constexpr size_t STEP = sizeof(__m512i) / sizeof(limb);
+  // The masks are 0 or all ones, so their low 32 bits broadcast to the whole vector.
+  __m512i masks[] = {_mm512_set1_epi32(static_cast<int>(a_mask)), _mm512_set1_epi32(static_cast<int>(b_mask)),
+                     _mm512_set1_epi32(static_cast<int>(r_mask))};
+  size_t i = 0;
+  for (; i + STEP <= n; i += STEP) {
+    __m512i x = _mm512_xor_si512(_mm512_loadu_si512(a + i), masks[0]);
+    __m512i y = _mm512_xor_si512(_mm512_loadu_si512(b + i), masks[1]);
+    if constexpr (std::is_same_v<F, std::bit_and<>>) {
+      x = _mm512_and_si512(x, y);
+    } else if constexpr (std::is_same_v<F, std::bit_or<>>) {
+      x = _mm512_or_si512(x, y);
+    } else {
+      x = _mm512_xor_si512(x, y);
+    }
+    x = _mm512_xor_si512(x, masks[2]);
+    _mm512_storeu_si512(r + i, x);
+  }
+  bitwise_n_generic<F>(r + i, a + i, b + i, n - i, a_mask, b_mask, r_mask);
+}
+#endif
+
+// Kernel tiers in increasing order of required CPU features.
+enum class cpu_tier { generic, adx, avx2, avx512 };
+
+constexpr std::array<std::string_view, 4> CPU_TIER_NAMES = {"generic", "adx", "avx2", "avx512"};
+
+// Hot loops called through pointers resolved once at startup, so a single binary uses the best kernels
+// the CPU offers. Each tier also includes the kernels of the tiers below it.
+struct kernel_table {
+  limb (*add_n)(limb*, const limb*, const limb*, size_t) = add_n_generic;
+  limb (*sub_n)(limb*, const limb*, const limb*, size_t) = sub_n_generic;
+  limb (*addmul_1)(limb*, const limb*, size_t, limb) = addmul_1_generic;
+  limb (*submul_1)(limb*, const limb*, size_t, limb) = submul_1_generic;
+  limb (*mul_1)(limb*, const limb*, size_t, limb) = mul_1_generic;
+  limb (*lshift)(limb*, const limb*, size_t, unsigned) = lshift_generic;
+  void (*rshift)(limb*, const limb*, size_t, unsigned) = rshift_generic;
+  void (*and_n)(limb*, const limb*, const limb*, size_t, limb, limb, limb) = bitwise_n_generic<std::bit_and<>>;
+  void (*ior_n)(limb*, const limb*, const limb*, size_t, limb, limb, limb) = bitwise_n_generic<std::bit_or<>>;
+  void (*xor_n)(limb*, const limb*, const limb*, size_t, limb, limb, limb) = bitwise_n_generic<std::bit_xor<>>;
+};
+
+cpu_tier detect_cpu_tier() {
+#ifdef BIG_INTEGER_X86_KERNELS
+  __builtin_cpu_init();
+  if (!__builtin_cpu_supports("adx") || !__builtin_cpu_supports("bmi2")) {
+    return cpu_tier::generic;
+  }
+  if (!__builtin_cpu_supports("avx2")) {
+    return cpu_tier::adx;
+  }
+  return __builtin_cpu_supports("avx512f") ? cpu_tier::avx512 : cpu_tier::avx2;
+#else
+  return cpu_tier::generic;
+#endif
+}
+
+// The detected tier, lowered to the one named by BIG_INTEGER_CPU if it is set. Runs once at startup, an unknown name
+// is reported on stderr and leaves the detected tier.
+cpu_tier select_cpu_tier() {
+  cpu_tier tier = detect_cpu_tier();
+  const char* forced = std::getenv("BIG_INTEGER_CPU");
+  if (forced) {
+    auto it = std::find(CPU_TIER_NAMES.begin(), CPU_TIER_NAMES.end(), forced);
+    if (it != CPU_TIER_NAMES.end()) {
+      tier = std::min(tier, static_cast<cpu_tier>(it - CPU_TIER_NAMES.begin()));
+    } else {
+      std::cerr << "big_integer: ignoring unknown BIG_INTEGER_CPU=" << forced
+                << ", expected one of generic, adx, avx2, avx512\n";
+    }
+  }
+  return tier;
+}
+
+kernel_table make_kernel_table(cpu_tier tier) {
+  kernel_table table;
+#ifdef BIG_INTEGER_X86_KERNELS
+  if (tier >= cpu_tier::adx) {
+    table.add_n = add_n_adx;
+    table.sub_n = sub_n_adx;
+    table.addmul_1 = addmul_1_adx;
+    table.submul_1 = submul_1_adx;
+    table.mul_1 = mul_1_adx;
+  }
+  if (tier >= cpu_tier::avx2) {
+    table.lshift = lshift_avx2;
+    table.rshift = rshift_avx2;
+  }
+  if (tier == cpu_tier::avx2) {
+    table.and_n = bitwise_n_avx2<std::bit_and<>>;
+    table.ior_n = bitwise_n_avx2<std::bit_or<>>;
+    table.xor_n = bitwise_n_avx2<std::bit_xor<>>;
+  }
+  if (tier == cpu_tier::avx512) {
+    table.and_n = bitwise_n_avx512<std::bit_and<>>;
+    table.ior_n = bitwise_n_avx512<std::bit_or<>>;
+    table.xor_n = bitwise_n_avx512<std::bit_xor<>>;
+  }
+#endif
+  return table;
+}
+
+// Starts out generic, so values built during static initialization of other translation units stay correct.
+constinit kernel_table kernels;
+[[maybe_unused]] const bool kernels_selected = (kernels = make_kernel_table(select_cpu_tier()), true);
+
+// Entry points used by the rest of the code.
+inline limb add_n(limb* r, const limb* a, const limb* b, size_t n) {
+  return kernels.add_n(r, a, b, n);
+}
+
+inline limb sub_n(limb* r, const limb* a, const limb* b, size_t n) {
+  return kernels.sub_n(r, a, b, n);
+}
+
+inline limb addmul_1(limb* r, const limb* a, size_t n, limb m) {
+  return kernels.addmul_1(r, a, n, m);
+}
+
+inline limb submul_1(limb* r, const limb* a, size_t n, limb m) {
+  return kernels.submul_1(r, a, n, m);
+}
+
+inline limb mul_1(limb* r, const limb* a, size_t n, limb m) {
+  return kernels.mul_1(r, a, n, m);
+}
+
+inline limb lshift(limb* r, const limb* a, size_t n, unsigned shift) {
+  return kernels.lshift(r, a, n, shift);
+}
+
+inline void rshift(limb* r, const limb* a, size_t n, unsigned shift) {
+  kernels.rshift(r, a, n, shift);
+}
+
+template <typename F>
+void bitwise_n(limb* r, const limb* a, const limb* b, size_t n, limb a_mask = 0, limb b_mask = 0, limb r_mask = 0) {
+  if constexpr (std::is_same_v<F, std::bit_and<>>) {
+    kernels.and_n(r, a, b, n, a_mask, b_mask, r_mask);
+  } else if constexpr (std::is_same_v<F, std::bit_or<>>) {
+    kernels.ior_n(r, a, b, n, a_mask, b_mask, r_mask);
+  } else {
+    kernels.xor_n(r, a, b, n, a_mask, b_mask, r_mask);
+  }
+}
+
+// r = a + b for an >= bn, r may coincide with a or b. The carry loop stops at the first limb that absorbs it,
+// so adding a short b in place costs O(bn) amortized.
+limb add(limb* r, const limb* a, size_t an, const limb* b, size_t bn) {
+  limb carry = add_n(r, a, b, bn);
+  size_t i = bn;
+  for (; carry && i < an; ++i) {
+    r[i] = a[i] + 1;
+    carry = !r[i];
+  }
+  if (r != a) {
+    std::copy(a + i, a + an, r + i);
+  }
+  return carry;
+}
+
+// r = a - b for an >= bn, r may coincide with a or b. Stops early like add.
+limb sub(limb* r, const limb* a, size_t an, const limb* b, size_t bn) {
+  limb borrow = sub_n(r, a, b, bn);
+  size_t i = bn;
+  for (; borrow && i < an; ++i) {
+    limb x = a[i];
+    r[i] = x - 1;
+    borrow = !x;
+  }
+  if (r != a) {
+    std::copy(a + i, a + an, r + i);
+  }
+  return borrow;
+}
+
+int cmp_n(const limb* a, const limb* b, size_t n) {
+  while (n-- > 0) {
+    if (a[n] != b[n]) {
+      return a[n] < b[n] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+// r = |a - b| for an >= bn, r has an limbs. Returns whether a < b.
+bool abs_sub(limb* r, const limb* a, size_t an, const limb* b, size_t bn) {
+  bool less = std::all_of(a + bn, a + an, [](limb x) { return !x; }) && cmp_n(a, b, bn) < 0;
+  if (less) {
+    sub_n(r, b, a, bn);
+    std::fill(r + bn, r + an, 0);
+  } else {
+    sub(r, a, an, b, bn);
+  }
+  return less;
+}
+
+// r = a * (hi * B + lo), r has n + 2 limbs and may coincide with a.
+void mul_2(limb* r, const limb* a, size_t n, limb lo, limb hi) {
+  double_limb carry = 0;
+  limb prev = 0;
+  for (size_t i = 0; i <= n; ++i) {
+    limb cur = i < n ? a[i] : 0;
+    double_limb low = static_cast<double_limb>(cur) * lo + (carry & loc_consts::CHUNK_MAX);
+    double_limb high = static_cast<double_limb>(prev) * hi + (low & loc_consts::CHUNK_MAX);
+    r[i] = static_cast<limb>(high);
+    carry = (carry >> loc_consts::CHUNK_SIZE) + (low >> loc_consts::CHUNK_SIZE) + (high >> loc_consts::CHUNK_SIZE);
+    prev = cur;
+  }
+  r[n + 1] = static_cast<limb>(carry);
+}
+
+void mul_basecase(limb* r, const limb* a, size_t an, const limb* b, size_t bn) {
+  r[bn] = mul_1(r, b, bn, a[0]);
+  for (size_t i = 1; i < an; ++i) {
+    r[i + bn] = addmul_1(r + i, b, bn, a[i]);
+  }
+}
+
+// r = a * a, r has 2 * n limbs. Every cross product a[i] * a[j] is computed once and doubled.
+void sqr_basecase(limb* r, const limb* a, size_t n) {
+  if (!n) {
+    return;
+  }
+  std::fill(r, r + 2 * n, 0);
+  for (size_t i = 0; i + 1 < n; ++i) {
+    r[i + n] = addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+  }
+  lshift(r, r, 2 * n, 1);
+  double_limb carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    double_limb square = static_cast<double_limb>(a[i]) * a[i];
+    carry += r[2 * i] + (square & loc_consts::CHUNK_MAX);
+    r[2 * i] = static_cast<limb>(carry);
+    carry >>= loc_consts::CHUNK_SIZE;
+    carry += r[2 * i + 1] + (square >> loc_consts::CHUNK_SIZE);
+    r[2 * i + 1] = static_cast<limb>(carry);
+    carry >>= loc_consts::CHUNK_SIZE;
+  }
+}
+
+// Scratch space needed by mul_karatsuba for an x bn limbs, mirrors its recursion.
+size_t karatsuba_itch(size_t an, size_t bn) {
+  size_t itch = 0;
+  while (bn >= loc_consts::KARATSUBA_THRESHOLD) {
+    if (an + 1 >= 2 * bn) {
+      itch += 2 * bn;
+      an = bn;
+    } else {
+      size_t h = (an + 1) / 2;
+      itch += 4 * h + 1;
+      an = bn = h;
+    }
+  }
+  return itch;
+}
+
+// r = a * b for an >= bn, r has an + bn limbs, ws has at least karatsuba_itch(an, bn) limbs.
+void mul_karatsuba(limb* r, const limb* a, size_t an, const limb* b, size_t bn, limb* ws) {
+  if (bn < loc_consts::KARATSUBA_THRESHOLD) {
+    mul_basecase(r, a, an, b, bn);
+    return;
+  }
+  if (an + 1 >= 2 * bn) {
+    // Too unbalanced to split evenly: multiply b by bn-sized blocks of a and accumulate.
+    mul_karatsuba(r, a, bn, b, bn, ws);
+    for (size_t offset = bn; offset < an; offset += bn) {
+      size_t len = std::min(bn, an - offset);
+      mul_karatsuba(ws, b, bn, a + offset, len, ws + 2 * bn);
+      limb carry = add_n(r + offset, r + offset, ws, bn);
+      std::copy(ws + bn, ws + bn + len, r + offset + bn);
+      add(r + offset + bn, r + offset + bn, len, &carry, 1);
+    }
+    return;
+  }
+  // a = a1 * B^h + a0, b = b1 * B^h + b0, a0 * b1 + a1 * b0 = a0 * b0 + a1 * b1 - (a0 - a1) * (b0 - b1).
+  size_t h = (an + 1) / 2, s = an - h, t = bn - h;
+  limb* zd = ws;
+  limb* da = ws + 2 * h;
+  limb* db = ws + 3 * h;
+  limb* mid = ws + 2 * h;
+  limb* child = ws + 4 * h + 1;
+  bool negative = abs_sub(da, a, h, a + h, s) != abs_sub(db, b, h, b + h, t);
+  mul_karatsuba(zd, da, h, db, h, child);
+  mul_karatsuba(r, a, h, b, h, child);
+  mul_karatsuba(r + 2 * h, a + h, s, b + h, t, child);
+  std::copy(r, r + 2 * h, mid);
+  mid[2 * h] = 0;
+  add(mid, mid, 2 * h + 1, r + 2 * h, s + t);
+  if (negative) {
+    add(mid, mid, 2 * h + 1, zd, 2 * h);
+  } else {
+    sub(mid, mid, 2 * h + 1, zd, 2 * h);
+  }
+  add(r + h, r + h, h + s + t, mid, std::min(2 * h + 1, h + s + t));
+}
+
+// (u1 * B + u0) / d for d with the top bit set and u1 < d, the remainder replaces u1. v is the reciprocal
+// floor((B^2 - 1) / d) - B. The estimate from the high half of v * u1 + (u1 * B + u0) is off by at most one.
+inline limb div_2by1(limb& u1, limb u0, limb d, limb v) {
+  double_limb p = static_cast<double_limb>(v) * u1;
+  p += (static_cast<double_limb>(u1) << loc_consts::CHUNK_SIZE) | u0;
+  limb q = static_cast<limb>(p >> loc_consts::CHUNK_SIZE) + 1;
+  limb r = u0 - q * d;
+  if (r > static_cast<limb>(p)) {
+    --q;
+    r += d;
+  }
+  if (r >= d) {
+    ++q;
+    r -= d;
+  }
+  u1 = r;
+  return q;
+}
+
+// q = a / d, returns a % d. q may coincide with a. Computing the reciprocal costs about a division, so it is only
+// done for inputs longer than a couple of limbs.
+limb divrem_1(limb* q, const limb* a, size_t n, limb d) {
+  if (n > 2) {
+    return limb_divisor(d).divrem(q, a, n);
+  }
+  double_limb rem = 0;
+  for (size_t i = n; i-- > 0;) {
+    rem = (rem << loc_consts::CHUNK_SIZE) | a[i];
+    q[i] = static_cast<limb>(rem / d);
+    rem %= d;
+  }
+  return static_cast<limb>(rem);
+}
+
+// a % d without storing the quotient.
+limb mod_1(const limb* a, size_t n, limb d) {
+  if (n > 2) {
+    return limb_divisor(d).divrem(nullptr, a, n);
+  }
+  double_limb rem = 0;
+  for (size_t i = n; i-- > 0;) {
+    rem = ((rem << loc_consts::CHUNK_SIZE) | a[i]) % d;
+  }
+  return static_cast<limb>(rem);
+}
+
+// A 64-bit value as little-endian limbs, size counts the significant ones.
+struct small_limbs {
+  limb data[64 / loc_consts::CHUNK_SIZE] = {};
+  size_t size = 0;
+
+  explicit small_limbs(uint64_t value) {
+    for (; value; ++size) {
+      data[size] = static_cast<limb>(value);
+      if constexpr (loc_consts::CHUNK_SIZE < 64) {
+        value >>= loc_consts::CHUNK_SIZE % 64;
+      } else {
+        value = 0;
+      }
+    }
+  }
+};
+
+void mul(limb* r, const limb* a, size_t an, const limb* b, size_t bn);
+void sqr(limb* r, const limb* a, size_t n);
+
+size_t sqr_karatsuba_itch(size_t n) {
+  size_t itch = 0;
+  for (; n >= loc_consts::SQR_KARATSUBA_THRESHOLD; n = (n + 1) / 2) {
+    itch += 4 * ((n + 1) / 2) + 1;
+  }
+  return itch;
+}
+
+// r = a * a, r has 2 * n limbs, ws has at least sqr_karatsuba_itch(n) limbs. The middle term is
+// 2 * a0 * a1 = a0^2 + a1^2 - (a0 - a1)^2, so all three recursive products are squares.
+void sqr_karatsuba(limb* r, const limb* a, size_t n, limb* ws) {
+  if (n < loc_consts::SQR_KARATSUBA_THRESHOLD) {
+    sqr_basecase(r, a, n);
+    return;
+  }
+  size_t h = (n + 1) / 2, s = n - h;
+  limb* zd = ws;
+  limb* da = ws + 2 * h;
+  limb* mid = ws + 2 * h;
+  limb* child = ws + 4 * h + 1;
+  abs_sub(da, a, h, a + h, s);
+  sqr_karatsuba(zd, da, h, child);
+  sqr_karatsuba(r, a, h, child);
+  sqr_karatsuba(r + 2 * h, a + h, s, child);
+  std::copy(r, r + 2 * h, mid);
+  mid[2 * h] = 0;
+  add(mid, mid, 2 * h + 1, r + 2 * h, 2 * s);
+  sub(mid, mid, 2 * h + 1, zd, 2 * h);
+  add(r + h, r + h, h + 2 * s, mid, std::min(2 * h + 1, h + 2 * s));
+}
+
+// Normalized (no leading zero limbs) temporaries for the Toom-Cook evaluation and interpolation steps.
+using limb_vector = std::vector<limb>;
+
+void normalize(limb_vector& x) noexcept {
+  while (!x.empty() && !x.back()) {
+    x.pop_back();
+  }
+}
+
+bool less(const limb_vector& x, const limb_vector& y) noexcept {
+  return x.size() != y.size() ? x.size() < y.size() : cmp_n(x.data(), y.data(), x.size()) < 0;
+}
+
+void add_to(limb_vector& x, const limb_vector& y) {
+  x.resize(std::max(x.size(), y.size()) + 1);
+  add(x.data(), x.data(), x.size(), y.data(), y.size());
+  normalize(x);
+}
+
+// x -= y for x >= y.
+void sub_from(limb_vector& x, const limb_vector& y) {
+  sub(x.data(), x.data(), x.size(), y.data(), y.size());
+  normalize(x);
+}
+
+// (x, x_negative) += (y, y_negative) in sign-magnitude form.
+void add_signed(limb_vector& x, bool& x_negative, const limb_vector& y, bool y_negative) {
+  if (x_negative == y_negative) {
+    add_to(x, y);
+  } else if (less(x, y)) {
+    limb_vector tmp(y);
+    sub_from(tmp, x);
+    x.swap(tmp);
+    x_negative = y_negative;
+  } else {
+    sub_from(x, y);
+  }
+  x_negative = x_negative && !x.empty();
+}
+
+void mul_1_to(limb_vector& x, limb m) {
+  limb carry = mul_1(x.data(), x.data(), x.size(), m);
+  if (carry) {
+    x.push_back(carry);
+  }
+}
+
+void divexact_1_to(limb_vector& x, limb d) {
+  divrem_1(x.data(), x.data(), x.size(), d);
+  normalize(x);
+}
+
+// An evaluation may normalize to no limbs at all, e.g. a0 - a1 + a2 = 0, then both empty operands compare equal.
+limb_vector product(const limb_vector& x, const limb_vector& y) {
+  if (x.empty() || y.empty()) {
+    return {};
+  }
+  limb_vector result(x.size() + y.size());
+  if (x == y) {
+    sqr(result.data(), x.data(), x.size());
+  } else {
+    mul(result.data(), x.data(), x.size(), y.data(), y.size());
+  }
+  normalize(result);
+  return result;
+}
+
+std::vector<limb_vector> split(const limb* a, size_t an, size_t parts, size_t k) {
+  std::vector<limb_vector> result(parts);
+  for (size_t i = 0; i < parts; ++i) {
+    result[i].assign(a + i * k, a + std::min((i + 1) * k, an));
+    normalize(result[i]);
+  }
+  return result;
+}
+
+limb_vector evaluate_at_one(const std::vector<limb_vector>& parts) {
+  limb_vector result;
+  for (const limb_vector& part : parts) {
+    add_to(result, part);
+  }
+  return result;
+}
+
+limb_vector evaluate_at_minus_one(const std::vector<limb_vector>& parts, bool& negative) {
+  limb_vector result;
+  negative = false;
+  for (size_t i = 0; i < parts.size(); ++i) {
+    add_signed(result, negative, parts[i], i % 2);
+  }
+  return result;
+}
+
+limb_vector evaluate_at_two(const std::vector<limb_vector>& parts) {
+  limb_vector result;
+  for (size_t i = parts.size(); i-- > 0;) {
+    mul_1_to(result, 2);
+    add_to(result, parts[i]);
+  }
+  return result;
+}
+
+// r = a * b via Toom-Cook with a split into pa and b into pb parts of k limbs (the last ones may be shorter):
+// Toom-2.5 is (3, 2), Toom-3 is (3, 3), Toom-3.5 is (4, 2). Evaluation points are 0, 1, -1, (2,) infinity,
+// interpolation follows "Modern Computer Arithmetic", algorithm ToomCook3. For a square the evaluations of both
+// operands coincide and every pointwise product is a square as well.
+void mul_toom(limb* r, const limb* a, size_t an, const limb* b, size_t bn, size_t pa, size_t pb, size_t k) {
+  std::vector<limb_vector> a_parts = split(a, an, pa, k), b_parts = split(b, bn, pb, k);
+  bool a_negative = false, b_negative = false;
+  limb_vector v0 = product(a_parts.front(), b_parts.front());
+  limb_vector v1 = product(evaluate_at_one(a_parts), evaluate_at_one(b_parts));
+  limb_vector vm1 = product(evaluate_at_minus_one(a_parts, a_negative), evaluate_at_minus_one(b_parts, b_negative));
+  limb_vector vinf = product(a_parts.back(), b_parts.back());
+  bool vm1_negative = a_negative != b_negative && !vm1.empty();
+  std::vector<limb_vector> c;
+  if (pa + pb == 5) {
+    // c1 + c3 = (v1 - vm1) / 2, c0 + c2 = (v1 + vm1) / 2.
+    limb_vector odd(v1), even(v1);
+    bool odd_negative = false, even_negative = false;
+    add_signed(odd, odd_negative, vm1, !vm1_negative);
+    add_signed(even, even_negative, vm1, vm1_negative);
+    divexact_1_to(odd, 2);
+    divexact_1_to(even, 2);
+    sub_from(odd, vinf);
+    sub_from(even, v0);
+    c = {std::move(v0), std::move(odd), std::move(even), std::move(vinf)};
+  } else {
+    limb_vector v2 = product(evaluate_at_two(a_parts), evaluate_at_two(b_parts));
+    // t1 = (3 * v0 + 2 * vm1 + v2) / 6 - 2 * vinf, t2 = (v1 + vm1) / 2.
+    limb_vector t1(v0), t2(v1), twice_vm1(vm1), twice_vinf(vinf);
+    bool t1_negative = false, t2_negative = false;
+    mul_1_to(t1, 3);
+    add_to(t1, v2);
+    mul_1_to(twice_vm1, 2);
+    add_signed(t1, t1_negative, twice_vm1, vm1_negative);
+    divexact_1_to(t1, 6);
+    mul_1_to(twice_vinf, 2);
+    sub_from(t1, twice_vinf);
+    add_signed(t2, t2_negative, vm1, vm1_negative);
+    divexact_1_to(t2, 2);
+    // c1 = v1 - t1, c2 = t2 - v0 - vinf, c3 = t1 - t2.
+    sub_from(v1, t1);
+    sub_from(t1, t2);
+    sub_from(t2, v0);
+    sub_from(t2, vinf);
+    c = {std::move(v0), std::move(v1), std::move(t2), std::move(t1), std::move(vinf)};
+  }
+  std::fill(r, r + an + bn, 0);
+  for (size_t i = 0; i < c.size(); ++i) {
+    add(r + i * k, r + i * k, an + bn - i * k, c[i].data(), c[i].size());
+  }
+}
+
+// Arithmetic modulo an NTT-friendly prime p = c * 2^k + 1 < 2^31 in Montgomery form with R = 2^32.
+template <uint32_t P, uint32_t G>
+struct ntt_prime {
+  static constexpr uint32_t MOD = P;
+
+  static constexpr uint32_t neg_inverse() noexcept {
+    uint32_t inv = P;
+    for (int i = 0; i < 4; ++i) {
+      inv *= 2 - P * inv;
+    }
+    return -inv;
+  }
+
+  static constexpr uint32_t NEG_INV = neg_inverse();
+  static constexpr uint32_t R1 = static_cast<uint32_t>((uint64_t(1) << 32) % P);
+  static constexpr uint32_t R2 = static_cast<uint32_t>(uint64_t(R1) * R1 % P);
+
+  static uint32_t reduce(uint64_t t) noexcept {
+    uint32_t m = static_cast<uint32_t>(t) * NEG_INV;
+    auto u = static_cast<uint32_t>((t + static_cast<uint64_t>(m) * P) >> 32);
+    return u >= P ? u - P : u;
+  }
+
+  static uint32_t mul(uint32_t a, uint32_t b) noexcept {
+    return reduce(static_cast<uint64_t>(a) * b);
+  }
+
+  static uint32_t add(uint32_t a, uint32_t b) noexcept {
+    uint32_t res = a + b;
+    return res >= P ? res - P : res;
+  }
+
+  static uint32_t sub(uint32_t a, uint32_t b) noexcept {
+    return a >= b ? a - b : a + P - b;
+  }
+
+  static uint32_t to_mont(uint32_t a) noexcept {
+    return mul(a, R2);
+  }
+
+  static uint32_t pow(uint32_t base, uint64_t exp) noexcept {
+    uint32_t res = R1;
+    for (; exp; exp >>= 1) {
+      if (exp & 1) {
+        res = mul(res, base);
+      }
+      base = mul(base, base);
+    }
+    return res;
+  }
+
+  // roots[len + j] = w^j for the primitive 2 * len-th root of unity w (or its inverse), len = 1, 2, ..., n / 2.
+  static void roots(std::vector<uint32_t>& roots, size_t n, bool inverse) {
+    roots.resize(n);
+    for (size_t len = 1; len < n; len <<= 1) {
+      uint32_t w = pow(to_mont(G), (P - 1) / (2 * len));
+      if (inverse) {
+        w = pow(w, 2 * len - 1);
+      }
+      uint32_t cur = R1;
+      for (size_t j = 0; j < len; ++j) {
+        roots[len + j] = cur;
+        cur = mul(cur, w);
+      }
+    }
+  }
+
+  struct root_tables {
+    std::vector<uint32_t> forward, inverse;
+  };
+
+  // Root tables for a transform of length n. Tables of a longer transform start with the shorter ones, so each thread
+  // keeps its longest tables up to NTT_ROOTS_CACHE for later products, longer ones are built into the caller's local.
+  static const root_tables& cached_roots(root_tables& local, size_t n) {
+    thread_local root_tables cache;
+    root_tables& tables = n <= loc_consts::NTT_ROOTS_CACHE ? cache : local;
+    if (tables.forward.size() < n) {
+      roots(tables.forward, n, false);
+      roots(tables.inverse, n, true);
+    }
+    return tables;
+  }
+
+  // Decimation in frequency, natural order in, bit-reversed order out.
+  static void forward(uint32_t* a, size_t n, const uint32_t* w) noexcept {
+    for (size_t len = n / 2; len > 0; len >>= 1) {
+      for (size_t i = 0; i < n; i += 2 * len) {
+        for (size_t j = 0; j < len; ++j) {
+          uint32_t u = a[i + j], v = a[i + j + len];
+          a[i + j] = add(u, v);
+          a[i + j + len] = mul(sub(u, v), w[len + j]);
+        }
+      }
+    }
+  }
+
+  // Decimation in time, bit-reversed order in, natural order out, not scaled by 1 / n.
+  static void inverse(uint32_t* a, size_t n, const uint32_t* w) noexcept {
+    for (size_t len = 1; len < n; len <<= 1) {
+      for (size_t i = 0; i < n; i += 2 * len) {
+        for (size_t j = 0; j < len; ++j) {
+          uint32_t u = a[i + j], v = mul(a[i + j + len], w[len + j]);
+          a[i + j] = add(u, v);
+          a[i + j + len] = sub(u, v);
+        }
+      }
+    }
+  }
+
+  // res = a * b mod (x^n - 1, P), n is a power of two.
+  static void convolve(std::vector<uint32_t>& res, const uint32_t* a, size_t an, const uint32_t* b, size_t bn,
+                       size_t n) {
+    bool square = a == b && an == bn;
+    std::vector<uint32_t> fb(square ? 0 : n);
+    root_tables local;
+    const root_tables& w = cached_roots(local, n);
+    res.assign(n, 0);
+    std::transform(a, a + an, res.begin(), [](uint32_t x) { return x % P; });
+    forward(res.data(), n, w.forward.data());
+    if (square) {
+      for (uint32_t& x : res) {
+        x = mul(x, x);
+      }
+    } else {
+      std::transform(b, b + bn, fb.begin(), [](uint32_t x) { return x % P; });
+      forward(fb.data(), n, w.forward.data());
+      for (size_t i = 0; i < n; ++i) {
+        res[i] = mul(res[i], fb[i]);
+      }
+    }
+    inverse(res.data(), n, w.inverse.data());
+    // Pointwise products carry an extra R^-1, the scale compensates it together with 1 / n.
+    uint32_t scale = to_mont(pow(to_mont(static_cast<uint32_t>(n % P)), P - 2));
+    for (uint32_t& x : res) {
+      x = mul(x, scale);
+    }
+  }
+};
+
+using ntt_prime_1 = ntt_prime<2'013'265'921, 31>; // 15 * 2^27 + 1
+using ntt_prime_2 = ntt_prime<469'762'049, 3>;    // 7 * 2^26 + 1
+using ntt_prime_3 = ntt_prime<167'772'161, 3>;    // 5 * 2^25 + 1
+
+// A coefficient of a product with n <= NTT_MAX_LENGTH coefficients in total sums at most n / 2 products of two 32-bit
+// values, so it stays below 2^23 * 2^64 = 2^87 while P1 * P2 * P3 is about 2^87.04.
+static_assert(__extension__ static_cast<unsigned __int128>(ntt_prime_1::MOD) * ntt_prime_2::MOD * ntt_prime_3::MOD >
+              __extension__ static_cast<unsigned __int128>(loc_consts::NTT_MAX_LENGTH / 2) *
+                  std::numeric_limits<uint32_t>().max() * std::numeric_limits<uint32_t>().max());
+
+// Whether a product of n limbs fits the NTT: every convolution coefficient must stay below the product of the primes.
+bool ntt_fits(size_t n) {
+  return n * (loc_consts::CHUNK_SIZE / 32) <= loc_consts::NTT_MAX_LENGTH;
+}
+
+// r = a * b on 32-bit coefficients via three NTTs modulo word-sized primes and CRT.
+void mul_ntt_32(uint32_t* r, const uint32_t* a, size_t an, const uint32_t* b, size_t bn) {
+  constexpr uint64_t MASK = std::numeric_limits<uint32_t>().max();
+  size_t n = std::bit_ceil(an + bn - 1);
+  std::vector<uint32_t> r1, r2, r3;
+  ntt_prime_1::convolve(r1, a, an, b, bn, n);
+  ntt_prime_2::convolve(r2, a, an, b, bn, n);
+  ntt_prime_3::convolve(r3, a, an, b, bn, n);
+  constexpr uint64_t P1 = ntt_prime_1::MOD, P2 = ntt_prime_2::MOD, P3 = ntt_prime_3::MOD;
+  constexpr auto inv = [](uint64_t x, uint64_t p) {
+    uint64_t res = 1;
+    for (uint64_t exp = p - 2; exp; exp >>= 1, x = x * x % p) {
+      if (exp & 1) {
+        res = res * x % p;
+      }
+    }
+    return res;
+  };
+  constexpr uint64_t P1_INV_P2 = inv(P1 % P2, P2), P1P2_INV_P3 = inv(P1 * P2 % P3, P3);
+  // Garner: x = y1 + P1 * (y2 + P2 * y3), accumulated into a three limb carry.
+  uint64_t carry[3] = {0, 0, 0};
+  for (size_t i = 0; i < an + bn; ++i) {
+    uint64_t y1 = 0, y2 = 0, y3 = 0;
+    if (i < n) {
+      y1 = r1[i];
+      y2 = (r2[i] + P2 - y1 % P2) * P1_INV_P2 % P2;
+      y3 = ((r3[i] + P3 - (y1 + P1 * y2) % P3) % P3) * P1P2_INV_P3 % P3;
+    }
+    uint64_t inner = y2 + P2 * y3;
+    uint64_t lo = P1 * (inner & MASK) + y1;
+    uint64_t hi = P1 * (inner >> 32) + (lo >> 32);
+    uint64_t x[3] = {lo & MASK, hi & MASK, hi >> 32};
+    uint64_t sum = carry[0] + x[0];
+    r[i] = static_cast<uint32_t>(sum);
+    sum = carry[1] + x[1] + (sum >> 32);
+    carry[0] = sum & MASK;
+    sum = carry[2] + x[2] + (sum >> 32);
+    carry[1] = sum & MASK;
+    carry[2] = sum >> 32;
+  }
+}
+
+// r = a * b via NTT, requires ntt_fits(an + bn). Wider limbs are convolved as 32-bit halves.
+void mul_ntt(limb* r, const limb* a, size_t an, const limb* b, size_t bn) {
+#ifndef BIG_INTEGER_64BIT_LIMBS
+  mul_ntt_32(r, a, an, b, bn);
+#else
+  constexpr size_t HALVES = loc_consts::CHUNK_SIZE / 32;
+  auto split_halves = [](const limb* x, size_t n) {
+    std::vector<uint32_t> result(n * HALVES);
+    for (size_t i = 0; i < result.size(); ++i) {
+      result[i] = static_cast<uint32_t>(x[i / HALVES] >> (32 * (i % HALVES)));
+    }
+    return result;
+  };
+  std::vector<uint32_t> ha = split_halves(a, an);
+  std::vector<uint32_t> hb = a == b && an == bn ? std::vector<uint32_t>() : split_halves(b, bn);
+  const std::vector<uint32_t>& rhs = hb.empty() ? ha : hb;
+  std::vector<uint32_t> hr(ha.size() + rhs.size());
+  mul_ntt_32(hr.data(), ha.data(), ha.size(), rhs.data(), rhs.size());
+  std::fill(r, r + an + bn, 0);
+  for (size_t i = 0; i < hr.size(); ++i) {
+    r[i / HALVES] |= static_cast<limb>(hr[i]) << (32 * (i % HALVES));
+  }
+#endif
+}
+
+// r = a * b for an >= bn >= TOOM_THRESHOLD, picks the Toom variant matching the operands ratio.
+void mul_toom_dispatch(limb* r, const limb* a, size_t an, const limb* b, size_t bn) {
+  if (4 * an < 5 * bn) {
+    mul_toom(r, a, an, b, bn, 3, 3, (an + 2) / 3);
+  } else if (4 * an < 7 * bn) {
+    mul_toom(r, a, an, b, bn, 3, 2, std::max((an + 2) / 3, (bn + 1) / 2));
+  } else if (2 * an < 5 * bn) {
+    mul_toom(r, a, an, b, bn, 4, 2, std::max((an + 3) / 4, (bn + 1) / 2));
+  } else {
+    // Multiply b by 2 * bn sized blocks of a, each of them is a Toom-3.5 product.
+    size_t block = 2 * bn;
+    limb_vector tmp(block + bn);
+    mul_toom(r, a, block, b, bn, 4, 2, (bn + 1) / 2);
+    for (size_t offset = block; offset < an; offset += block) {
+      size_t len = std::min(block, an - offset);
+      mul(tmp.data(), a + offset, len, b, bn);
+      limb carry = add_n(r + offset, r + offset, tmp.data(), bn);
+      std::copy(tmp.begin() + bn, tmp.begin() + bn + len, r + offset + bn);
+      add(r + offset + bn, r + offset + bn, len, &carry, 1);
+    }
+  }
+}
+
+// r = a * b, r has an + bn limbs.
+void mul(limb* r, const limb* a, size_t an, const limb* b, size_t bn) {
+  if (a == b && an == bn) {
+    sqr(r, a, an);
+    return;
+  }
+  if (an < bn) {
+    std::swap(a, b);
+    std::swap(an, bn);
+  }
+  if (bn < loc_consts::KARATSUBA_THRESHOLD) {
+    mul_basecase(r, a, an, b, bn);
+  } else if (bn < loc_consts::TOOM_THRESHOLD) {
+    std::vector<limb> ws(karatsuba_itch(an, bn));
+    mul_karatsuba(r, a, an, b, bn, ws.data());
+  } else if (bn < loc_consts::NTT_THRESHOLD || !ntt_fits(an + bn)) {
+    mul_toom_dispatch(r, a, an, b, bn);
+  } else {
+    mul_ntt(r, a, an, b, bn);
+  }
+}
+
+// Scratch space needed by mul_ws for an x bn limbs.
+size_t mul_ws_itch(size_t an, size_t bn) {
+  size_t low = std::min(an, bn);
+  if (low >= loc_consts::TOOM_THRESHOLD) {
+    return 0;
+  }
+  return std::max(karatsuba_itch(std::max(an, bn), low), sqr_karatsuba_itch(low));
+}
+
+// mul for callers multiplying in a loop: Karatsuba-sized products take their scratch from ws, which has at least
+// mul_ws_itch(an, bn) limbs, instead of allocating it. Toom-Cook and NTT sizes still allocate.
+void mul_ws(limb* r, const limb* a, size_t an, const limb* b, size_t bn, limb* ws) {
+  if (an < bn) {
+    std::swap(a, b);
+    std::swap(an, bn);
+  }
+  if (bn >= loc_consts::TOOM_THRESHOLD) {
+    mul(r, a, an, b, bn);
+  } else if (a == b && an == bn) {
+    sqr_karatsuba(r, a, an, ws);
+  } else {
+    mul_karatsuba(r, a, an, b, bn, ws);
+  }
+}
+
+// Knuth's algorithm D: a has n + m limbs, d has n limbs with the highest bit set. Stores the low m quotient limbs
+// to q, returns the highest one (0 or 1) and leaves the remainder in a[0, n).
+limb divrem_basecase(limb* q, limb* a, size_t n, size_t m, const limb* d) {
+  limb qh = cmp_n(a + m, d, n) >= 0;
+  if (qh) {
+    sub_n(a + m, a + m, d, n);
+  }
+  limb d1 = d[n - 1], d0 = n > 1 ? d[n - 2] : 0;
+  for (size_t j = m; j-- > 0;) {
+    double_limb top = (static_cast<double_limb>(a[j + n]) << loc_consts::CHUNK_SIZE) | a[j + n - 1];
+    double_limb qhat = a[j + n] >= d1 ? loc_consts::CHUNK_MAX : top / d1;
+    double_limb rhat = top - qhat * d1;
+    while (n > 1 && rhat <= loc_consts::CHUNK_MAX &&
+           qhat * d0 > ((rhat << loc_consts::CHUNK_SIZE) | a[j + n - 2])) {
+      --qhat;
+      rhat += d1;
+    }
+    limb borrow = submul_1(a + j, d, n, static_cast<limb>(qhat));
+    bool negative = a[j + n] < borrow;
+    a[j + n] -= borrow;
+    for (; negative; --qhat) {
+      negative = !add_n(a + j, a + j, d, n);
+      a[j + n] += !negative;
+    }
+    q[j] = static_cast<limb>(qhat);
+  }
+  return qh;
+}
+
+// Scratch space needed by divrem_recursive for a quotient of m limbs: the block products and their own scratch.
+// Toom-Cook sized products need none, so the deeper levels may need more than the top one.
+size_t divrem_recursive_itch(size_t m) {
+  size_t itch = 0;
+  for (; m >= loc_consts::DIV_THRESHOLD; m -= m / 2) {
+    itch = std::max(itch, m + mul_ws_itch(m - m / 2, m / 2));
+  }
+  return itch;
+}
+
+// Recursive division from "Modern Computer Arithmetic", algorithm RecursiveDivRem (Burnikel-Ziegler), with the
+// same contract as divrem_basecase for m <= n. ws has at least divrem_recursive_itch(m) limbs, so the block
+// products below Toom-Cook sizes allocate nothing.
+limb divrem_recursive(limb* q, limb* a, size_t n, size_t m, const limb* d, limb* ws) {
+  if (m < loc_consts::DIV_THRESHOLD) {
+    return divrem_basecase(q, a, n, m, d);
+  }
+  const limb one = 1;
+  size_t k = m / 2;
+  // (q1, a[2k, n + k)) = a[2k, n + m) divmod d[k, n), then a[0, n + k) -= q1 * d[0, k) * B^k.
+  limb qh = divrem_recursive(q + k, a + 2 * k, n - k, m - k, d + k, ws);
+  mul_ws(ws, q + k, m - k, d, k, ws + m);
+  limb borrow = sub(a + k, a + k, n, ws, m);
+  if (qh) {
+    borrow += sub(a + m, a + m, n + k - m, d, k);
+  }
+  for (; borrow; borrow -= add(a + k, a + k, n, d, n)) {
+    qh -= sub(q + k, q + k, m - k, &one, 1);
+  }
+  // (q0, a[k, n)) = a[k, n + k) divmod d[k, n), then a[0, n) -= q0 * d[0, k).
+  limb ql = divrem_recursive(q, a + k, n - k, k, d + k, ws);
+  mul_ws(ws, q, k, d, k, ws + m);
+  borrow = sub(a, a, n, ws, 2 * k);
+  if (ql) {
+    borrow += sub(a + k, a + k, n - k, d, k);
+  }
+  for (; borrow; borrow -= add(a, a, n, d, n)) {
+    sub(q, q, k, &one, 1);
+  }
+  return qh;
+}
+
+// q = a / b, r = a % b for an >= bn and b[bn - 1] != 0. q has an - bn + 1 limbs, r has bn limbs. Either of them
+// may be null when not needed, both may overlap the operands. All the work, including the scratch of the block
+// products of the recursive division, is done in a single buffer. It lives on the stack while it fits
+// DIV_STACK_LIMBS, which covers dividing 300 limbs by 150, so only longer operands allocate.
+void divrem(limb* q, limb* r, const limb* a, size_t an, const limb* b, size_t bn) {
+  auto shift = static_cast<unsigned>(std::countl_zero(b[bn - 1]));
+  size_t m = an + 1 - bn;
+  bool recursive = bn >= loc_consts::DIV_THRESHOLD && m >= loc_consts::DIV_THRESHOLD;
+  size_t size = an + 1 + bn + (recursive ? divrem_recursive_itch(std::min(m, bn)) : 0) + m;
+  std::array<limb, loc_consts::DIV_STACK_LIMBS> local;
+  std::vector<limb> heap(size > local.size() ? size : 0);
+  limb* na = heap.empty() ? local.data() : heap.data();
+  limb* nd = na + an + 1;
+  limb* nq = nd + bn;
+  limb* ws = nq + m;
+  if (shift) {
+    na[an] = lshift(na, a, an, shift);
+    lshift(nd, b, bn, shift);
+  } else {
+    na[an] = 0;
+    std::copy(a, a + an, na);
+    std::copy(b, b + bn, nd);
+  }
+  if (!recursive) {
+    divrem_basecase(nq, na, bn, m, nd);
+  } else {
+    // Quotient limbs are produced by blocks of at most bn limbs from the top, each block is a balanced division.
+    size_t offset = m - ((m - 1) % bn + 1);
+    divrem_recursive(nq + offset, na + offset, bn, m - offset, nd, ws);
+    while (offset > 0) {
+      offset -= bn;
+      divrem_recursive(nq + offset, na + offset, bn, bn, nd, ws);
+    }
+  }
+  if (q) {
+    std::copy(nq, nq + m, q);
+  }
+  if (r && shift) {
+    rshift(r, na, bn, shift);
+  } else if (r) {
+    std::copy(na, na + bn, r);
+  }
+}
+
+// r = a * a, r has 2 * n limbs, n may be zero.
+void sqr(limb* r, const limb* a, size_t n) {
+  if (n < loc_consts::SQR_KARATSUBA_THRESHOLD) {
+    sqr_basecase(r, a, n);
+  } else if (n < loc_consts::TOOM_THRESHOLD) {
+    std::vector<limb> ws(sqr_karatsuba_itch(n));
+    sqr_karatsuba(r, a, n, ws.data());
+  } else if (n < loc_consts::NTT_THRESHOLD || !ntt_fits(2 * n)) {
+    mul_toom(r, a, n, a, n, 3, 3, (n + 2) / 3);
+  } else {
+    mul_ntt(r, a, n, a, n);
+  }
+}
+
+// Short products for sizes where they beat a full Karatsuba product. mul_low_basecase stores the low k limbs of
+// a * b to r. mul_high_basecase stores to r[s, an + bn) the sum of the products a[i] * b[j] with i + j >= s only,
+// so the number in r[s, an + bn) * B^s falls short of a * b by less than (s + 1) * B^(s + 1).
+void mul_low_basecase(limb* r, const limb* a, size_t an, const limb* b, size_t bn, size_t k) {
+  std::fill(r, r + k, 0);
+  for (size_t i = 0; i < an && i < k; ++i) {
+    limb carry = addmul_1(r + i, b, std::min(bn, k - i), a[i]);
+    if (i + bn < k) {
+      r[i + bn] = carry;
+    }
+  }
+}
+
+void mul_high_basecase(limb* r, const limb* a, size_t an, const limb* b, size_t bn, size_t s) {
+  std::fill(r + s, r + an + bn, 0);
+  for (size_t i = 0; i < an; ++i) {
+    size_t j = s > i ? s - i : 0;
+    if (j < bn) {
+      r[i + bn] = addmul_1(r + i + j, b + j, bn - j, a[i]);
+    }
+  }
+}
+
+// -m^-1 mod B for odd m. Every odd m is its own inverse modulo 8, and each Newton step doubles the correct bits.
+limb montgomery_inverse(limb m) {
+  limb inv = m;
+  for (unsigned bits = 3; bits < loc_consts::CHUNK_SIZE; bits *= 2) {
+    inv *= 2 - m * inv;
+  }
+  return -inv;
+}
+
+// Montgomery reduction: r = t / B^n mod m for an odd n-limb m and 2n-limb t < m * B^n, t is destroyed. Each step
+// zeroes the lowest limb of t and parks the addmul carry in it, the carries are added back at once in the end.
+// With constant_time the final subtraction of m is always computed and selected by a mask.
+void redc(limb* r, limb* t, const limb* m, size_t n, limb inv, bool constant_time) {
+  for (size_t i = 0; i < n; ++i) {
+    t[i] = addmul_1(t + i, m, n, t[i] * inv);
+  }
+  limb carry = add_n(r, t + n, t, n);
+  if (!constant_time) {
+    if (carry || cmp_n(r, m, n) >= 0) {
+      sub_n(r, r, m, n);
+    }
+    return;
+  }
+  limb borrow = sub_n(t, r, m, n);
+  limb mask = limb(0) - (carry | (borrow ^ 1));
+  for (size_t i = 0; i < n; ++i) {
+    r[i] ^= (r[i] ^ t[i]) & mask;
+  }
+}
+
+// Multiplication of n-limb residues in Montgomery form, the results may coincide with the operands. The constant
+// time flavour sticks to the schoolbook kernels, which have no data-dependent branches.
+struct montgomery_multiplier {
+  const limb* m;
+  size_t n;
+  limb inv;
+  bool constant_time;
+  limb_vector t = limb_vector(2 * n);
+
+  void multiply(limb* r, const limb* a, const limb* b) {
+    if (constant_time) {
+      mul_basecase(t.data(), a, n, b, n);
+    } else {
+      mul(t.data(), a, n, b, n);
+    }
+    redc(r, t.data(), m, n, inv, constant_time);
+  }
+
+  void square(limb* r, const limb* a) {
+    if (constant_time) {
+      sqr_basecase(t.data(), a, n);
+    } else {
+      sqr(t.data(), a, n);
+    }
+    redc(r, t.data(), m, n, inv, constant_time);
+  }
+};
+
+// Bits [lo, hi) of the exponent e as a number, hi - lo is at most a limb.
+limb exponent_bits(const limb* e, size_t lo, size_t hi) {
+  limb value = 0;
+  for (size_t i = hi; i-- > lo;) {
+    value = (value << 1) | ((e[i / loc_consts::CHUNK_SIZE] >> (i % loc_consts::CHUNK_SIZE)) & 1);
+  }
+  return value;
+}
+
+// Sliding window width for an exponent of the given bit length, it balances the 2^(w - 1) table products against
+// about bits / (w + 1) window products.
+size_t window_width(size_t bits) {
+  size_t width = 1;
+  for (size_t threshold : {24, 80, 240, 672, 1792}) {
+    width += bits > threshold;
+  }
+  return width;
+}
+
+// GCD. Both numbers are reduced by matrices M with non-negative entries and det M = 1: (a, b) = M * (a', b') keeps
+// the gcd and M^-1 = [[m11, -m01], [-m10, m00]]. A single step subtracts a multiple of the smaller number from the
+// larger one in place, a -= q * b is M = [[1, q], [0, 1]] and b -= q * a is M = [[1, 0], [q, 1]], so there are no
+// swaps and no signs to track.
+using limb_matrix = std::array<std::array<limb, 2>, 2>;
+
+struct gcd_matrix {
+  limb_vector m[2][2] = {{{1}, {}}, {{}, {1}}};
+};
+
+// The value of at most 64 bits of limbs.
+uint64_t to_uint64(const limb* a, size_t n) noexcept {
+  uint64_t value = 0;
+  for (size_t i = n; i-- > 0;) {
+    value = (value << (loc_consts::CHUNK_SIZE % 64)) | a[i];
+  }
+  return value;
+}
+
+size_t bit_length(const limb_vector& a) noexcept {
+  return a.empty() ? 0 : (a.size() - 1) * loc_consts::CHUNK_SIZE + std::bit_width(a.back());
+}
+
+// Bits [p, p + 2 * CHUNK_SIZE) of a.
+double_limb bits_at(const limb_vector& a, size_t p) noexcept {
+  auto at = [&a](size_t i) { return static_cast<double_limb>(i < a.size() ? a[i] : 0); };
+  size_t i = p / loc_consts::CHUNK_SIZE;
+  unsigned shift = p % loc_consts::CHUNK_SIZE;
+  double_limb result = ((at(i + 1) << loc_consts::CHUNK_SIZE) | at(i)) >> shift;
+  if (shift) {
+    result |= at(i + 2) << (2 * loc_consts::CHUNK_SIZE - shift);
+  }
+  return result;
+}
+
+// a[p, size) and a[0, p), normalized.
+limb_vector limbs_from(const limb_vector& a, size_t p) {
+  return p < a.size() ? limb_vector(a.begin() + static_cast<ptrdiff_t>(p), a.end()) : limb_vector();
+}
+
+limb_vector limbs_below(const limb_vector& a, size_t p) {
+  limb_vector result(a.begin(), a.begin() + static_cast<ptrdiff_t>(std::min(p, a.size())));
+  normalize(result);
+  return result;
+}
+
+// Double-digit Lehmer step: Euclid on ah and bh, the bits of a and b from p on, with single-limb entries. As
+// a' = 2^p * ah' + (m11 * a_low - m01 * b_low) >= 2^p * (ah' - m01) + m01, and similarly for b', a step is taken
+// only while the reduced top stays at least its grown entry plus bound. This keeps a' and b' positive and at least
+// bound * 2^p whatever the lower bits are, so no quotient has to be verified. Exact tops (p = 0) are compared with
+// the bound directly. Returns whether any step was taken.
+bool lehmer_matrix(double_limb ah, double_limb bh, double_limb bound, bool exact, limb_matrix& m) {
+  double_limb m00 = 1, m01 = 0, m10 = 0, m11 = 1;
+  bool reduced = false;
+  for (;;) {
+    bool a_step = ah >= bh;
+    double_limb& x = a_step ? ah : bh;
+    double_limb y = a_step ? bh : ah;
+    // a -= q * b adds q times column 0 to column 1, b -= q * a the other way around.
+    double_limb& checked = a_step ? m01 : m10;
+    double_limb& other = a_step ? m11 : m00;
+    double_limb checked_step = a_step ? m00 : m11;
+    double_limb other_step = a_step ? m10 : m01;
+    if (!y) {
+      break;
+    }
+    double_limb q = 1, r = x - y;
+    if (r >= y) {
+      q = x / y;
+      r = x - q * y;
+    }
+    if (q > loc_consts::CHUNK_MAX) {
+      break;
+    }
+    double_limb new_checked = checked + q * checked_step, new_other = other + q * other_step;
+    if (new_checked > loc_consts::CHUNK_MAX || new_other > loc_consts::CHUNK_MAX ||
+        r < (exact ? 0 : new_checked) + bound) {
+      break;
+    }
+    x = r;
+    checked = new_checked;
+    other = new_other;
+    reduced = true;
+  }
+  m = {{{static_cast<limb>(m00), static_cast<limb>(m01)}, {static_cast<limb>(m10), static_cast<limb>(m11)}}};
+  return reduced;
+}
+
+// (a, b) = M^-1 * (a, b) = (m11 * a - m01 * b, m00 * b - m10 * a), both known to be non-negative and at most the
+// old values, so the carries cancel out.
+void reduce_1(limb_vector& a, limb_vector& b, const limb_matrix& m, limb_vector& t) {
+  size_t n = std::max(a.size(), b.size());
+  a.resize(n);
+  b.resize(n);
+  t.resize(n);
+  mul_1(t.data(), a.data(), n, m[1][1]);
+  submul_1(t.data(), b.data(), n, m[0][1]);
+  mul_1(b.data(), b.data(), n, m[0][0]);
+  submul_1(b.data(), a.data(), n, m[1][0]);
+  a.swap(t);
+  normalize(a);
+  normalize(b);
+}
+
+// (x, y) = (x, y) * M for a row of an accumulated matrix.
+void mul_row_1(limb_vector& x, limb_vector& y, const limb_matrix& m, limb_vector& t) {
+  size_t n = std::max(x.size(), y.size());
+  x.resize(n + 2);
+  y.resize(n + 2);
+  t.resize(n + 2);
+  t[n] = mul_1(t.data(), x.data(), n, m[0][0]);
+  limb carry = addmul_1(t.data(), y.data(), n, m[1][0]);
+  t[n] += carry;
+  t[n + 1] = t[n] < carry;
+  carry = mul_1(y.data(), y.data(), n, m[1][1]);
+  y[n] = addmul_1(y.data(), x.data(), n, m[0][1]);
+  y[n] += carry;
+  y[n + 1] = y[n] < carry;
+  x.swap(t);
+  normalize(x);
+  normalize(y);
+}
+
+void mul_row(limb_vector& x, limb_vector& y, const gcd_matrix& m) {
+  limb_vector new_x = product(x, m.m[0][0]);
+  add_to(new_x, product(y, m.m[1][0]));
+  limb_vector new_y = product(x, m.m[0][1]);
+  add_to(new_y, product(y, m.m[1][1]));
+  x.swap(new_x);
+  y.swap(new_y);
+}
+
+// hi * B^p + x * x_low - y * y_low, known to be non-negative.
+limb_vector recombine(const limb_vector& hi, size_t p, const limb_vector& x, const limb_vector& x_low,
+                      const limb_vector& y, const limb_vector& y_low) {
+  limb_vector result(p);
+  result.insert(result.end(), hi.begin(), hi.end());
+  add_to(result, product(x, x_low));
+  sub_from(result, product(y, y_low));
+  return result;
+}
+
+// (a, b) = M^-1 * (a, b) when the limbs of a and b from p on have already been reduced by M to ah and bh.
+void reduce_split(limb_vector& a, limb_vector& b, const limb_vector& ah, const limb_vector& bh, const gcd_matrix& m,
+                  size_t p) {
+  limb_vector a_low = limbs_below(a, p), b_low = limbs_below(b, p);
+  a = recombine(ah, p, m.m[1][1], a_low, m.m[0][1], b_low);
+  b = recombine(bh, p, m.m[0][0], b_low, m.m[1][0], a_low);
+}
+
+// a = a mod b for a >= b > 0, returns the quotient if asked for.
+limb_vector divmod_to(limb_vector& a, const limb_vector& b, bool quotient) {
+  size_t an = a.size(), bn = b.size();
+  limb_vector q(quotient ? an - bn + 1 : 0);
+  if (bn == 1) {
+    limb r = quotient ? divrem_1(q.data(), a.data(), an, b[0]) : mod_1(a.data(), an, b[0]);
+    a.assign(1, r);
+  } else {
+    divrem(quotient ? q.data() : nullptr, a.data(), a.data(), an, b.data(), bn);
+    a.resize(bn);
+  }
+  normalize(a);
+  normalize(q);
+  return q;
+}
+
+// Steps on a and b accumulated into M while both stay at least B^s: Lehmer steps while the top bits allow them,
+// otherwise a -= q * b (or the other way around) with the largest q keeping the result at least B^s. Stops when
+// |a - b| < B^s.
+bool hgcd_steps(limb_vector& a, limb_vector& b, size_t s, gcd_matrix& m) {
+  limb_vector t;
+  limb_matrix step;
+  bool reduced = false;
+  size_t bound_bits = s * loc_consts::CHUNK_SIZE;
+  while (a.size() > s && b.size() > s) {
+    size_t bits = std::max(bit_length(a), bit_length(b));
+    size_t p = bits > 2 * loc_consts::CHUNK_SIZE ? bits - 2 * loc_consts::CHUNK_SIZE : 0;
+    double_limb bound = p == 0 || bound_bits >= p ? double_limb(1) << (bound_bits - p) : 1;
+    if (lehmer_matrix(bits_at(a, p), bits_at(b, p), bound, p == 0, step)) {
+      reduce_1(a, b, step, t);
+      mul_row_1(m.m[0][0], m.m[0][1], step, t);
+      mul_row_1(m.m[1][0], m.m[1][1], step, t);
+      reduced = true;
+      continue;
+    }
+    bool a_step = less(b, a);
+    limb_vector& x = a_step ? a : b;
+    const limb_vector& y = a_step ? b : a;
+    limb_vector power(s + 1);
+    power[s] = 1;
+    limb_vector rest = x;
+    sub_from(rest, power);
+    if (less(rest, y)) {
+      break;
+    }
+    limb_vector q = divmod_to(rest, y, true);
+    add_to(rest, power);
+    x.swap(rest);
+    // a -= q * b adds q times column 0 to column 1, b -= q * a the other way around.
+    size_t to = a_step ? 1 : 0;
+    for (auto& row : m.m) {
+      add_to(row[to], product(q, row[1 - to]));
+    }
+    reduced = true;
+  }
+  return reduced;
+}
+
+// Half GCD as in Moller, "On Schonhage's algorithm and subquadratic integer GCD computation". For the larger of
+// a and b having n limbs and s = n / 2 + 1, reduces both by M as far as possible while both stay at least B^s,
+// which bounds the entries of M by B^(n - s) < B^s. Returns whether any step was taken.
+//
+// Long inputs are reduced by two recursive calls on their top limbs. When the tops from limb p on, k limbs long, are
+// reduced to at least B^(k / 2 + 1) by M, the entries of M are below B^(k / 2) and the whole numbers stay at least
+// B^(p + k / 2) by the bound in lehmer_matrix. The first call takes the upper half, the second one is positioned
+// to leave both numbers at least B^(s + 1), and the last limb or so is left to hgcd_steps.
+bool hgcd(limb_vector& a, limb_vector& b, gcd_matrix& m) {
+  size_t n = std::max(a.size(), b.size()), s = n / 2 + 1;
+  m = gcd_matrix();
+  if (a.size() <= s || b.size() <= s) {
+    return false;
+  }
+  bool reduced = false;
+  if (n >= loc_consts::HGCD_THRESHOLD) {
+    gcd_matrix part;
+    size_t p = n / 2;
+    limb_vector ah = limbs_from(a, p), bh = limbs_from(b, p);
+    if (hgcd(ah, bh, part)) {
+      reduce_split(a, b, ah, bh, part, p);
+      std::swap(m, part);
+      reduced = true;
+    }
+    n = std::max(a.size(), b.size());
+    if (n >= s + 2) {
+      p = 2 * s + 2 - n;
+      ah = limbs_from(a, p);
+      bh = limbs_from(b, p);
+      if (hgcd(ah, bh, part)) {
+        reduce_split(a, b, ah, bh, part, p);
+        mul_row(m.m[0][0], m.m[0][1], part);
+        mul_row(m.m[1][0], m.m[1][1], part);
+        reduced = true;
+      }
+    }
+  }
+  return hgcd_steps(a, b, s, m) || reduced;
+}
+
+// gcd(a, b) for normalized a and b. With a non-null x also finds the Bezout coefficient of a, a * x = gcd mod b,
+// as a magnitude at most b / gcd and its sign. It is the second row (m10, m11) of the product M of all steps: the
+// process ends with (gcd, 0) = (m11 * a - m01 * b, ...) or (0, gcd) = (..., m00 * b - m10 * a).
+limb_vector gcd(limb_vector a, limb_vector b, limb_vector* x, bool* x_negative) {
+  limb_vector u0, u1{1}, t;
+  limb_matrix step;
+  while (!a.empty() && !b.empty()) {
+    size_t n = std::max(a.size(), b.size());
+    if (!x && n <= 64 / loc_consts::CHUNK_SIZE) {
+      small_limbs g(std::gcd(to_uint64(a.data(), a.size()), to_uint64(b.data(), b.size())));
+      return limb_vector(g.data, g.data + g.size);
+    }
+    if (n >= loc_consts::GCD_HGCD_THRESHOLD) {
+      // A half GCD of the top two thirds removes about a third of the limbs at once.
+      gcd_matrix m;
+      size_t p = n / 3;
+      limb_vector ah = limbs_from(a, p), bh = limbs_from(b, p);
+      if (hgcd(ah, bh, m)) {
+        reduce_split(a, b, ah, bh, m, p);
+        if (x) {
+          mul_row(u0, u1, m);
+        }
+        continue;
+      }
+    } else {
+      size_t bits = std::max(bit_length(a), bit_length(b));
+      size_t p = bits > 2 * loc_consts::CHUNK_SIZE ? bits - 2 * loc_consts::CHUNK_SIZE : 0;
+      if (lehmer_matrix(bits_at(a, p), bits_at(b, p), 0, p == 0, step)) {
+        reduce_1(a, b, step, t);
+        if (x) {
+          mul_row_1(u0, u1, step, t);
+        }
+        continue;
+      }
+    }
+    // The numbers differ in length too much for the top bits to give a quotient.
+    bool a_step = less(b, a);
+    limb_vector q = divmod_to(a_step ? a : b, a_step ? b : a, x != nullptr);
+    if (x) {
+      add_to(a_step ? u1 : u0, product(q, a_step ? u0 : u1));
+    }
+  }
+  bool b_zero = b.empty();
+  if (x) {
+    *x = b_zero ? std::move(u1) : std::move(u0);
+    *x_negative = !b_zero && !x->empty();
+  }
+  return b_zero ? a : b;
+}
+
+// A base together with its largest power fitting a limb: conversions work in chunks of `digits` digits.
+struct radix {
+  unsigned base;
+  size_t digits = 0;
+  limb chunk = 1;
+  limb_divisor divisor = limb_divisor(1);
+
+  explicit radix(unsigned base) : base(base) {
+    for (; chunk <= loc_consts::CHUNK_MAX / base; chunk *= base) {
+      ++digits;
+    }
+    divisor = limb_divisor(chunk);
+  }
+
+  // Number of chunks enough to hold any n-limb number.
+  size_t chunks_for(size_t n) const {
+    return static_cast<size_t>(static_cast<double>(n) * loc_consts::CHUNK_SIZE / std::log2(chunk)) + 2;
+  }
+};
+
+constexpr char DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+unsigned digit_value(char c) noexcept {
+  if ('0' <= c && c <= '9') {
+    return c - '0';
+  }
+  if ('a' <= c && c <= 'z') {
+    return c - 'a' + 10;
+  }
+  if ('A' <= c && c <= 'Z') {
+    return c - 'A' + 10;
+  }
+  return loc_consts::MAX_BASE;
+}
+
+// p[k] = chunk^(2^k) for k up to the top level of one conversion. Powers up to RADIX_CACHE_LIMBS are kept per thread
+// and base, larger ones live only as long as the table.
+struct radix_powers {
+  const std::vector<limb_vector>* cached;
+  std::vector<limb_vector> local;
+
+  radix_powers(const radix& rad, size_t k) {
+    thread_local std::array<std::vector<limb_vector>, loc_consts::MAX_BASE + 1> cache;
+    auto square = [](const limb_vector& p) {
+      limb_vector next(2 * p.size());
+      sqr(next.data(), p.data(), p.size());
+      normalize(next);
+      return next;
+    };
+    std::vector<limb_vector>& powers = cache[rad.base];
+    if (powers.empty()) {
+      powers.push_back({rad.chunk});
+    }
+    while (powers.size() <= k && 2 * powers.back().size() <= loc_consts::RADIX_CACHE_LIMBS) {
+      powers.push_back(square(powers.back()));
+    }
+    cached = &powers;
+    for (size_t i = powers.size(); i <= k; ++i) {
+      local.push_back(square(local.empty() ? powers.back() : local.back()));
+    }
+  }
+
+  const limb_vector& operator[](size_t k) const {
+    return k < cached->size() ? (*cached)[k] : local[k - cached->size()];
+  }
+};
+
+// Writes exactly rad.digits * chunks digits of a < chunk^chunks to out, leading zeros included. a is destroyed.
+void to_radix_basecase(char* out, limb* a, size_t n, size_t chunks, const radix& rad) {
+  for (char* p = out + chunks * rad.digits; p != out;) {
+    limb chunk = rad.divisor.divrem(a, a, n);
+    while (n && !a[n - 1]) {
+      --n;
+    }
+    for (size_t i = 0; i < rad.digits; ++i, chunk /= rad.base) {
+      *--p = DIGITS[chunk % rad.base];
+    }
+  }
+}
+
+// Same as above, splitting a by the largest power of the table below it.
+void to_radix(char* out, limb* a, size_t n, size_t chunks, const radix& rad, const radix_powers& powers) {
+  while (n && !a[n - 1]) {
+    --n;
+  }
+  if (n < loc_consts::TO_STRING_THRESHOLD) {
+    return to_radix_basecase(out, a, n, chunks, rad);
+  }
+  size_t k = std::bit_width(chunks - 1) - 1, low = size_t(1) << k;
+  char* mid = out + (chunks - low) * rad.digits;
+  const limb_vector& p = powers[k];
+  if (n < p.size()) {
+    std::fill(out, mid, '0');
+    return to_radix(mid, a, n, low, rad, powers);
+  }
+  limb_vector q(n - p.size() + 1);
+  divrem(q.data(), a, a, n, p.data(), p.size());
+  to_radix(out, q.data(), q.size(), chunks - low, rad, powers);
+  to_radix(mid, a, p.size(), low, rad, powers);
+}
+
+// Writes exactly len digits of a in base 2^bits to out: every digit is a bit field of a.
+void to_pow2_radix(char* out, size_t len, const limb* a, size_t n, unsigned bits) {
+  limb mask = (limb(1) << bits) - 1;
+  for (size_t i = 0, pos = len * bits; i < len; ++i) {
+    pos -= bits;
+    size_t index = pos / loc_consts::CHUNK_SIZE, offset = pos % loc_consts::CHUNK_SIZE;
+    limb value = a[index] >> offset;
+    if (offset + bits > loc_consts::CHUNK_SIZE && index + 1 < n) {
+      value |= a[index + 1] << (loc_consts::CHUNK_SIZE - offset);
+    }
+    out[i] = DIGITS[value & mask];
+  }
+}
+
+// Value of the digits s[0, len) valid in rad.base, in chunks of rad.digits digits by Horner's rule.
+limb_vector from_radix_basecase(const char* s, size_t len, const radix& rad) {
+  limb_vector r((len + rad.digits - 1) / rad.digits);
+  size_t n = 0;
+  for (size_t i = 0, head = (len - 1) % rad.digits + 1; i < len;) {
+    double_limb carry = 0;
+    for (size_t end = i + head; i < end; ++i) {
+      carry = carry * rad.base + digit_value(s[i]);
+    }
+    for (size_t j = 0; j < n; ++j) {
+      carry += static_cast<double_limb>(r[j]) * rad.chunk;
+      r[j] = static_cast<limb>(carry);
+      carry >>= loc_consts::CHUNK_SIZE;
+    }
+    if (carry) {
+      r[n++] = static_cast<limb>(carry);
+    }
+    head = rad.digits;
+  }
+  r.resize(n);
+  return r;
+}
+
+// Same as above as hi * chunk^(2^k) + lo with the power taken from the table.
+limb_vector from_radix(const char* s, size_t len, const radix& rad, const radix_powers& powers) {
+  size_t chunks = (len + rad.digits - 1) / rad.digits;
+  if (chunks < loc_consts::FROM_STRING_THRESHOLD) {
+    return from_radix_basecase(s, len, rad);
+  }
+  size_t k = std::bit_width(chunks - 1) - 1, low = rad.digits << k;
+  limb_vector result = product(from_radix(s, len - low, rad, powers), powers[k]);
+  add_to(result, from_radix(s + len - low, low, rad, powers));
+  return result;
+}
+
+// Value of the digits s[0, len) in base 2^bits: every digit is copied into its bit field.
+limb_vector from_pow2_radix(const char* s, size_t len, unsigned bits) {
+  limb_vector r((len * bits + loc_consts::CHUNK_SIZE - 1) / loc_consts::CHUNK_SIZE);
+  for (size_t i = len, pos = 0; i-- > 0; pos += bits) {
+    limb value = digit_value(s[i]);
+    size_t index = pos / loc_consts::CHUNK_SIZE, offset = pos % loc_consts::CHUNK_SIZE;
+    r[index] |= value << offset;
+    if (offset + bits > loc_consts::CHUNK_SIZE) {
+      r[index + 1] |= value >> (loc_consts::CHUNK_SIZE - offset);
+    }
+  }
+  normalize(r);
+  return r;
+}
+} // namespace loc_kernels
+
 big_integer::big_integer() : _digits(), _negative(false) {}
 
 big_integer::big_integer(const big_integer& other) = default;
 
+big_integer::big_integer(big_integer&& other) noexcept
+    : _digits(std::move(other._digits)), _negative(std::exchange(other._negative, false)) {}
+
 big_integer::big_integer(int a) : big_integer(static_cast<long long>(a)) {}
 
 big_integer::big_integer(unsigned int a) : big_integer(static_cast<unsigned long long>(a)) {}
@@ -46,36 +1910,22 @@ big_integer::big_integer(long long a)
 big_integer::big_integer(unsigned long long a) : big_integer(a, false) {}
 
 big_integer::big_integer(unsigned long long a, bool sign) : _negative(sign) {
-  _digits.push_back(a);
-  if (a >>= loc_consts::CHUNK_SIZE) {
-    _digits.push_back(a);
-  }
-  reduce_zeroes();
+  assign_small(a, sign);
 }
 
-big_integer::big_integer(const std::string& str) : _negative(false) {
-  *this = 0;
+big_integer::big_integer(std::string_view str, int base) : _negative(false) {
+  if (base < 2 || base > static_cast<int>(loc_consts::MAX_BASE)) {
+    throw std::invalid_argument("Expected base in range [2, 36] while initializing big_integer with a string.");
+  }
   if (str.empty()) {
     throw std::invalid_argument("Expected valid number while initializing big_integer, empty string found.");
   }
-  bool sign = str[0] == '-';
-  if (sign && str.length() == 1) {
+  if (str == "-") {
     throw std::invalid_argument("Expected valid number while initializing big_integer, single dash found.");
   }
-  for (size_t i = sign; i < str.size(); ++i) {
-    if (!isdigit(static_cast<unsigned char>(str[i]))) {
-      throw std::invalid_argument("Met invalid character while initializing big_integer with a string.");
-    }
-  }
-  uint32_t digit = 0;
-  for (size_t i = sign; i < str.size(); i += loc_consts::TRANSITION_CHUNK_SIZE) {
-    unsigned long length = std::min(loc_consts::TRANSITION_CHUNK_SIZE, str.size() - i);
-    digit = std::stoi(str.substr(i, length));
-    mul(length == loc_consts::TRANSITION_CHUNK_SIZE ? loc_consts::TRANSITION_CHUNK
-                                                    : static_cast<uint32_t>(pow(loc_consts::BASE, length)));
-    add(digit);
+  if (from_chars(str.data(), str.data() + str.size(), *this, base).ptr != str.data() + str.size()) {
+    throw std::invalid_argument("Met invalid character while initializing big_integer with a string.");
   }
-  _negative = !(*this == 0) && sign;
 }
 
 big_integer::~big_integer() = default;
@@ -94,224 +1944,282 @@ void big_integer::reduce_zeroes() noexcept {
 
 big_integer& big_integer::operator=(const big_integer& other) = default;
 
-bool big_integer::abs_less(const big_integer& other) const {
+big_integer& big_integer::operator=(big_integer&& other) noexcept {
+  _digits = std::move(other._digits);
+  _negative = std::exchange(other._negative, false);
+  return *this;
+}
+
+// Limb counts decide first since there are no leading zero limbs, the limbs are only scanned for equal lengths.
+int big_integer::abs_compare(const big_integer& other) const noexcept {
   size_t size = _digits.size();
   if (size != other._digits.size()) {
-    return size < other._digits.size();
+    return size < other._digits.size() ? -1 : 1;
   }
-  return std::lexicographical_compare(_digits.rbegin(), _digits.rend(), other._digits.rbegin(), other._digits.rend());
+  return loc_kernels::cmp_n(_digits.data(), other._digits.data(), size);
+}
+
+int big_integer::compare_small(uint64_t magnitude, bool negative) const noexcept {
+  negative = negative && magnitude;
+  if (_negative != negative) {
+    return _negative ? -1 : 1;
+  }
+  loc_kernels::small_limbs limbs(magnitude);
+  size_t size = _digits.size();
+  int abs = size != limbs.size ? (size < limbs.size ? -1 : 1) : loc_kernels::cmp_n(_digits.data(), limbs.data, size);
+  return _negative ? -abs : abs;
 }
 
-bool big_integer::abs_eq(const big_integer& other) const {
-  return _digits == other._digits;
+int big_integer::sign() const noexcept {
+  return _negative ? -1 : !_digits.empty();
 }
 
-big_integer& big_integer::convert() noexcept {
-  if (_negative) {
-    uint64_t carry = true;
-    std::for_each(_digits.begin(), _digits.end(), [&carry](uint32_t& x) {
-      uint64_t res = ~x;
-      res += carry;
-      x = res;
-      carry = res >> loc_consts::CHUNK_SIZE;
-    });
-  }
-  return *this;
+bool big_integer::is_zero() const noexcept {
+  return _digits.empty();
 }
 
-big_integer big_integer::divide(big_integer& A, big_integer B) {
-  int shift = std::countl_zero(B._digits.back());
-  A <<= shift;
-  B <<= shift;
-  big_integer::vec_ref a = A._digits, b = B._digits;
-  size_t n = b.size(), m = a.size() - n;
-  big_integer Q;
-  big_integer::vec_ref q = Q._digits;
-  q.resize(m + 1);
-  if (A >= (B << static_cast<int>(m << loc_consts::CHUNK_SIZE_LOG2))) {
-    q[m] = 1;
-    A -= (B << static_cast<int>(m << loc_consts::CHUNK_SIZE_LOG2));
-  } else {
-    q[m] = 0;
+int big_integer::compare(int64_t other) const noexcept {
+  return compare_small(magnitude(other), other < 0);
+}
+
+void big_integer::divide(const big_integer& other, bool quotient) {
+  size_t an = _digits.size(), bn = other._digits.size();
+  if (an < bn) {
+    if (quotient) {
+      _digits.clear();
+    }
+    return;
   }
-  for (size_t j = m; j-- > 0;) {
-    uint64_t q_tmp =
-        n + j < a.size() ? ((static_cast<uint64_t>(a[n + j]) << loc_consts::CHUNK_SIZE) + a[n + j - 1]) / b[n - 1] : 0;
-    q[j] = std::min(q_tmp, loc_consts::BETTA - 1);
-    A -= ((big_integer(B).mul(q[j])) << static_cast<int>(j << loc_consts::CHUNK_SIZE_LOG2));
-    while (A < 0) {
-      --q[j];
-      A += (B << static_cast<int>(j << loc_consts::CHUNK_SIZE_LOG2));
+  if (bn == 1) {
+    limb remainder = loc_kernels::divrem_1(_digits.data(), _digits.data(), an, other._digits[0]);
+    if (!quotient) {
+      _digits.resize(1);
+      _digits[0] = remainder;
     }
+  } else if (quotient) {
+    loc_kernels::divrem(_digits.data(), nullptr, _digits.data(), an, other._digits.data(), bn);
+    _digits.resize(an - bn + 1);
+  } else {
+    loc_kernels::divrem(nullptr, _digits.data(), _digits.data(), an, other._digits.data(), bn);
+    _digits.resize(bn);
   }
-  A >>= shift;
-  Q.reduce_zeroes();
-  return Q;
+  reduce_zeroes();
 }
 
-big_integer big_integer::divide(const big_integer& other) {
-  if (abs_less(other)) {
-    return 0;
-  }
-  big_integer copy(*this);
-  big_integer quotient(divide(*this, big_integer(other)));
-  return quotient;
+big_integer& big_integer::assign_small(uint64_t magnitude, bool negative) {
+  loc_kernels::small_limbs limbs(magnitude);
+  _digits.assign(limbs.data, limbs.data + limbs.size);
+  _negative = negative && !_digits.empty();
+  return *this;
 }
 
-template <typename F>
-big_integer& big_integer::add_sub_chunk(uint32_t chunk, const F& f) {
-  bool carry = false;
-  _digits.resize(_digits.size() + (_digits.empty() ? 2 : 1));
-  int64_t res = f(f(!_digits.empty() ? _digits[0] : 0, chunk), carry);
-  _digits[0] = res;
-  carry = (res > loc_consts::CHUNK_MAX) || (res < 0);
-  for (size_t i = 1; carry; ++i) {
-    res = f(_digits[i], carry);
-    _digits[i] = res;
-    carry = res >> loc_consts::CHUNK_SIZE;
+// The carry or borrow stops at the first limb that absorbs it and the limbs only grow when it runs out of them,
+// so incrementing a counter is O(1) amortized.
+big_integer& big_integer::add_small(uint64_t magnitude, bool negative) {
+  loc_kernels::small_limbs small(magnitude);
+  limb* limbs = small.data;
+  size_t n = small.size, size = _digits.size();
+  if (!size) {
+    return assign_small(magnitude, negative);
+  }
+  if (_negative == negative) {
+    if (size < n) {
+      _digits.resize(n);
+    }
+    limb* d = _digits.data();
+    limb carry = size >= n ? loc_kernels::add(d, d, size, limbs, n) : loc_kernels::add(d, limbs, n, d, size);
+    if (carry) {
+      _digits.push_back(carry);
+    }
+    return *this;
+  }
+  if (size > n || (size == n && loc_kernels::cmp_n(_digits.data(), limbs, n) >= 0)) {
+    loc_kernels::sub(_digits.data(), _digits.data(), size, limbs, n);
+  } else {
+    loc_kernels::sub(limbs, limbs, n, _digits.data(), size);
+    _digits.assign(limbs, limbs + n);
+    _negative = negative;
   }
   reduce_zeroes();
+  _negative = _negative && !_digits.empty();
   return *this;
 }
 
-big_integer& big_integer::add(int32_t other) {
-  bool less = (_digits.empty() && !other) || (_digits.size() == 1 && _digits.front() < std::abs(other));
-  if (_negative == (other < 0)) {
-    add_sub_chunk(std::abs(other), std::plus<int64_t>());
-  } else {
-    if (less) {
-      if (_digits.empty()) {
-        _digits.push_back(std::abs(other));
-      } else {
-        _digits[0] = std::abs(other) - _digits[0];
-      }
-      _negative = other < 0;
-    } else {
-      add_sub_chunk(std::abs(other), std::minus<int64_t>());
+big_integer& big_integer::mul_small(uint64_t magnitude, bool negative) {
+  size_t size = _digits.size();
+  loc_kernels::small_limbs limbs(magnitude);
+  if (limbs.size < 2) {
+    limb carry = loc_kernels::mul_1(_digits.data(), _digits.data(), size, limbs.data[0]);
+    if (carry) {
+      _digits.push_back(carry);
     }
+  } else if (size) {
+    _digits.resize(size + 2);
+    loc_kernels::mul_2(_digits.data(), _digits.data(), size, limbs.data[0], limbs.data[1]);
   }
+  reduce_zeroes();
+  _negative = (_negative != negative) && !_digits.empty();
   return *this;
 }
 
-big_integer& big_integer::mul(uint32_t other) {
-  uint64_t carry = 0;
-  _digits.resize(_digits.size() + (_digits.empty() ? 2 : 1));
-  for (size_t i = 0; i < _digits.size(); ++i) {
-    uint64_t result = static_cast<uint64_t>(other) * _digits[i] + carry;
-    _digits[i] = result;
-    carry = result >> loc_consts::CHUNK_SIZE;
-  }
-  if (!other) {
-    _negative = false;
+big_integer& big_integer::div_small(uint64_t magnitude, bool negative) {
+  size_t size = _digits.size();
+  loc_kernels::small_limbs divisor(magnitude);
+  if (divisor.size < 2) {
+    loc_kernels::divrem_1(_digits.data(), _digits.data(), size, divisor.data[0]);
+  } else if (size < 2) {
+    _digits.clear();
+  } else {
+    loc_kernels::divrem(_digits.data(), nullptr, _digits.data(), size, divisor.data, 2);
+    _digits.resize(size - 1);
   }
   reduce_zeroes();
+  _negative = (_negative != negative) && !_digits.empty();
   return *this;
 }
 
-big_integer big_integer::div(uint32_t other) {
-  uint64_t carry = 0;
-  big_integer quotient;
-  quotient._digits.resize(_digits.size());
-  for (size_t i = _digits.size(); i-- > 0;) {
-    quotient._digits[i] = (carry + _digits[i]) / other;
-    _digits[i] = (carry + _digits[i]) % other;
-    carry = static_cast<uint64_t>(_digits[i]) << loc_consts::CHUNK_SIZE;
+uint64_t big_integer::rem_small(uint64_t magnitude) const {
+  loc_kernels::small_limbs divisor(magnitude);
+  if (divisor.size < 2) {
+    return loc_kernels::mod_1(_digits.data(), _digits.size(), divisor.data[0]);
   }
-  if (!other) {
-    _negative = false;
+  if (_digits.size() < 2) {
+    return _digits.empty() ? 0 : _digits[0];
   }
-  reduce_zeroes();
-  quotient.reduce_zeroes();
-  return quotient;
+  limb remainder[2];
+  loc_kernels::divrem(nullptr, remainder, _digits.data(), _digits.size(), divisor.data, 2);
+  return (static_cast<uint64_t>(remainder[1]) << (loc_consts::CHUNK_SIZE % 64)) | remainder[0];
 }
 
-big_integer::big_integer(vec vector) : _digits(vector), _negative(false) {}
+big_integer::big_integer(vec vector) : _digits(std::move(vector)), _negative(false) {}
 
 template <typename F>
 big_integer& big_integer::binary_bit_operation(const big_integer& other, const F& f) {
-  bool less = abs_less(other);
+  bool less = abs_compare(other) < 0;
   vector_bit_f(less ? other : *this, less ? *this : other, *this, f);
   return *this;
 }
 
 template <typename F>
 void big_integer::vector_bit_f(const big_integer& a, const big_integer& b, big_integer& result, const F& f) {
-  size_t max_len = std::max(a._digits.size(), b._digits.size());
-  bool a_carry = a._negative, b_carry = b._negative;
-  result._digits.resize(max_len);
-  for (size_t i = 0; i < max_len; ++i) {
-    uint64_t a_i = a._negative ? ~a._digits[i] : a._digits[i];
-    a_i += a_carry;
-    uint64_t b_i = b._negative ? ~b._digits[i] : b._digits[i];
-    b_i += b_carry;
-    a_carry = a_i > loc_consts::CHUNK_MAX;
-    b_carry = b_i > loc_consts::CHUNK_MAX;
-    result._digits[i] = f(a_i, b_i);
-  }
-  result._negative = f(a._negative, b._negative);
-  result.convert();
-  result.reduce_zeroes();
-}
+  // a is at least as long as b. In two's complement a negative -m is zero below the lowest nonzero limb k of m,
+  // -m[k] at k and ~m[i] above it, with ones beyond the top. So only the limbs up to the highest such k need the
+  // +1 carry, everything above is one pass of the dispatched kernel with complement masks.
+  size_t an = a._digits.size(), bn = b._digits.size();
+  auto lowest_nonzero = [](const limb* x, size_t from, size_t to) {
+    return static_cast<size_t>(std::find_if(x + from, x + to, [](limb d) { return d != 0; }) - x);
+  };
+  size_t a_low = a._negative ? lowest_nonzero(a._digits.data(), 0, an) : 0;
+  size_t b_low = b._negative ? lowest_nonzero(b._digits.data(), 0, bn) : 0;
+  size_t prefix = std::max(a._negative ? a_low + 1 : 0, b._negative ? b_low + 1 : 0);
+  auto twos_complement = [](const big_integer& x, size_t n, size_t low, size_t i) -> limb {
+    if (!x._negative) {
+      return i < n ? x._digits[i] : 0;
+    }
+    if (i >= n) {
+      return loc_consts::CHUNK_MAX;
+    }
+    return i < low ? 0 : static_cast<limb>(i == low ? -x._digits[i] : ~x._digits[i]);
+  };
+  limb a_mask = a._negative ? loc_consts::CHUNK_MAX : 0, b_mask = b._negative ? loc_consts::CHUNK_MAX : 0;
+  bool negative = f(a._negative, b._negative);
+
+  result._digits.resize(an);
+  limb* r = result._digits.data();
+  const limb* x = a._digits.data();
+  const limb* y = b._digits.data();
+  limb r_mask = 0;
+  for (size_t i = 0; i < prefix; ++i) {
+    r[i] = f(twos_complement(a, an, a_low, i), twos_complement(b, bn, b_low, i));
+  }
+  size_t r_low = lowest_nonzero(r, 0, prefix);
+  if (negative && r_low < prefix) {
+    r[r_low] = -r[r_low];
+    std::transform(r + r_low + 1, r + prefix, r + r_low + 1, [](limb d) { return ~d; });
+    r_mask = loc_consts::CHUNK_MAX;
+  }
+  if (prefix < bn) {
+    loc_kernels::bitwise_n<F>(r + prefix, x + prefix, y + prefix, bn - prefix, a_mask, b_mask, r_mask);
+  }
 
-template <typename F>
-void big_integer::vector_f(big_integer::const_vec_ref a, big_integer::const_vec_ref b, big_integer::vec_ref result,
-                           const F& f) {
-  bool carry = false;
-  result.resize(std::max(a.size(), b.size()) + 1);
-  for (size_t i = 0; i < a.size(); ++i) {
-    int64_t res = f(f(a[i], (i < b.size() ? b[i] : 0)), carry);
-    carry = (res > loc_consts::CHUNK_MAX) || (res < 0);
-    result[i] = res;
+  // Above b only its sign extension is left, against which f is either a constant or a masked copy of a.
+  size_t top = std::max(prefix, bn);
+  limb zero_image = f(limb(0), b_mask), ones_image = f(loc_consts::CHUNK_MAX, b_mask);
+  if (zero_image != ones_image) {
+    limb mask = a_mask ^ zero_image ^ r_mask;
+    if (r != x || mask) {
+      loc_kernels::bitwise_n<std::bit_and<>>(r + top, x + top, x + top, an - top, mask, mask);
+    }
+  } else if (zero_image ^ r_mask) {
+    std::fill(r + top, r + an, zero_image ^ r_mask);
+  } else {
+    result._digits.resize(top);
   }
-  if (carry) {
-    result[a.size()] = carry;
+
+  if (negative && !r_mask) {
+    // The lowest nonzero limb of the result lies above the prefix: complement it in a second pass.
+    r_low = lowest_nonzero(r, prefix, an);
+    if (r_low == an) {
+      result._digits.push_back(1);
+    } else {
+      r[r_low] = -r[r_low];
+      loc_kernels::bitwise_n<std::bit_and<>>(r + r_low + 1, r + r_low + 1, r + r_low + 1, an - r_low - 1,
+                                             loc_consts::CHUNK_MAX, loc_consts::CHUNK_MAX);
+    }
   }
+  result._negative = negative;
+  result.reduce_zeroes();
 }
 
-big_integer& big_integer::operator+=(const big_integer& other) {
-  bool less = abs_less(other);
-  big_integer::const_vec_ref greatest = less ? other._digits : _digits;
-  big_integer::const_vec_ref smallest = less ? _digits : other._digits;
-  if (_negative == other._negative) {
-    vector_f(greatest, smallest, _digits, std::plus<int64_t>());
+big_integer& big_integer::accumulate(const big_integer& other, bool subtract) {
+  size_t an = _digits.size(), bn = other._digits.size();
+  bool other_negative = other._negative != subtract;
+  if (!bn) {
+    return *this;
+  }
+  if (an < bn) {
+    _digits.resize(bn);
+  }
+  // Pointers are taken after the resize, so they stay valid when &other == this.
+  limb* r = _digits.data();
+  const limb* b = other._digits.data();
+  if (_negative == other_negative) {
+    limb carry = an >= bn ? loc_kernels::add(r, r, an, b, bn) : loc_kernels::add(r, b, bn, r, an);
+    if (carry) {
+      _digits.push_back(carry);
+    }
+    return *this;
+  }
+  if (an < bn || (an == bn && loc_kernels::cmp_n(r, b, an) < 0)) {
+    loc_kernels::sub(r, b, bn, r, an);
+    _negative = other_negative;
   } else {
-    vector_f(greatest, smallest, _digits, std::minus<int64_t>());
+    loc_kernels::sub(r, r, an, b, bn);
   }
   reduce_zeroes();
-  _negative = less ? other._negative : _negative && !abs_eq(0);
+  _negative = _negative && !_digits.empty();
   return *this;
 }
 
+big_integer& big_integer::operator+=(const big_integer& other) {
+  return accumulate(other, false);
+}
+
 big_integer& big_integer::operator-=(const big_integer& other) {
-  bool less = abs_less(other);
-  big_integer::const_vec_ref greatest = less ? other._digits : _digits;
-  big_integer::const_vec_ref smallest = less ? _digits : other._digits;
-  if (_negative == other._negative) {
-    vector_f(greatest, smallest, _digits, std::minus<int64_t>());
-  } else {
-    vector_f(greatest, smallest, _digits, std::plus<int64_t>());
-  }
-  reduce_zeroes();
-  _negative = less ? !other._negative : _negative && !abs_eq(0);
-  return *this;
+  return accumulate(other, true);
 }
 
 big_integer& big_integer::operator*=(const big_integer& other) {
-  size_t this_it = _digits.size();
-  ensure_size(_digits.size() + other._digits.size());
-  while (this_it-- > 0) {
-    uint64_t carry = 0;
-    uint64_t multiplier = _digits[this_it];
-    _digits[this_it] = 0;
-    size_t other_it = 0;
-    while (other_it < other._digits.size() || carry) {
-      const uint64_t result = (other_it < other._digits.size() ? other._digits[other_it] * multiplier : 0) +
-                              _digits[this_it + other_it] + carry;
-      _digits[this_it + other_it] = result;
-      carry = result >> loc_consts::CHUNK_SIZE;
-      other_it++;
-    }
+  if (_digits.empty() || other._digits.empty()) {
+    return *this = 0;
   }
+  vec result(_digits.size() + other._digits.size());
+  if (this == &other || _digits == other._digits) {
+    loc_kernels::sqr(result.data(), _digits.data(), _digits.size());
+  } else {
+    loc_kernels::mul(result.data(), _digits.data(), _digits.size(), other._digits.data(), other._digits.size());
+  }
+  _digits.swap(result);
   _negative = _negative ^ other._negative;
   reduce_zeroes();
   return *this;
@@ -319,21 +2227,22 @@ big_integer& big_integer::operator*=(const big_integer& other) {
 
 big_integer& big_integer::operator/=(const big_integer& other) {
   bool sign = _negative ^ other._negative;
-  big_integer divider(other);
-  divider._negative = false;
-  _negative = false;
-  *this = divide(divider);
-  _negative = sign;
+  divide(other, true);
+  _negative = sign && !_digits.empty();
+  return *this;
+}
+
+big_integer& big_integer::operator/=(const limb_divisor& rhs) {
+  rhs.divrem(_digits.data(), _digits.data(), _digits.size());
+  reduce_zeroes();
+  _negative = _negative && !_digits.empty();
   return *this;
 }
 
 big_integer& big_integer::operator%=(const big_integer& other) {
   bool sign = _negative;
-  big_integer divider(other);
-  divider._negative = false;
-  _negative = false;
-  divide(divider);
-  _negative = sign && *this != 0;
+  divide(other, false);
+  _negative = sign && !_digits.empty();
   return *this;
 }
 
@@ -350,60 +2259,93 @@ big_integer& big_integer::operator^=(const big_integer& other) {
 }
 
 big_integer& big_integer::operator<<=(int other) {
-  size_t shift = other / loc_consts::CHUNK_SIZE;
-  ensure_size(_digits.size() + shift + 2);
-  convert();
-  _digits.insert(_digits.begin(), shift, 0);
-  shift = other % loc_consts::CHUNK_SIZE;
-  for (size_t i = _digits.size() - 2; shift > 0 && i-- > other / loc_consts::CHUNK_SIZE;) {
-    _digits[i + 1] = (_digits[i + 1] << shift) | (_digits[i] >> (loc_consts::CHUNK_SIZE - shift));
-  }
-  _digits[other / loc_consts::CHUNK_SIZE] <<= shift;
-  for (size_t i = 0; i < other / loc_consts::CHUNK_SIZE; ++i) {
-    _digits[i] = 0;
-  }
-  convert();
+  size_t n = _digits.size();
+  if (!n || !other) {
+    return *this;
+  }
+  size_t limbs = other / loc_consts::CHUNK_SIZE;
+  unsigned bits = other % loc_consts::CHUNK_SIZE;
+  // The magnitude is shifted straight into place, into a fresh buffer if the current one is too small.
+  vec fresh;
+  bool in_place = _digits.capacity() >= n + limbs + 1;
+  vec& target = in_place ? _digits : fresh;
+  target.resize(n + limbs + 1);
+  if (bits) {
+    target[n + limbs] = loc_kernels::lshift(target.data() + limbs, _digits.data(), n, bits);
+  } else {
+    std::copy_backward(_digits.begin(), _digits.begin() + n, target.begin() + limbs + n);
+    target[n + limbs] = 0;
+  }
+  std::fill(target.begin(), target.begin() + limbs, 0);
+  if (!in_place) {
+    _digits.swap(fresh);
+  }
   reduce_zeroes();
   return *this;
 }
 
 big_integer& big_integer::operator>>=(int other) {
-  if (_digits.size() * loc_consts::CHUNK_SIZE < other) {
-    return _negative ? *this = -1 : *this = 0;
-  }
-  size_t shift = other / loc_consts::CHUNK_SIZE;
-  ensure_size(_digits.size() + 2);
-  convert();
-  _digits.erase(_digits.begin(), _digits.begin() + static_cast<uint32_t>(shift));
-  shift = other % loc_consts::CHUNK_SIZE;
-  for (size_t i = 0; shift > 0 && i < _digits.size() - 1; ++i) {
-    _digits[i] = (_digits[i + 1] << (loc_consts::CHUNK_SIZE - shift)) | (_digits[i] >> shift);
-  }
-  convert();
+  size_t n = _digits.size();
+  if (!n || !other) {
+    return *this;
+  }
+  size_t limbs = other / loc_consts::CHUNK_SIZE;
+  unsigned bits = other % loc_consts::CHUNK_SIZE;
+  if (limbs >= n) {
+    return *this = _negative ? -1 : 0;
+  }
+  // Shifting rounds towards minus infinity, so a negative value whose dropped bits are not all zero has its
+  // magnitude rounded up.
+  limb* d = _digits.data();
+  bool round_up = _negative && (std::any_of(d, d + limbs, [](limb x) { return x != 0; }) ||
+                                (bits && (d[limbs] & ((limb(1) << bits) - 1))));
+  if (bits) {
+    loc_kernels::rshift(d, d + limbs, n - limbs, bits);
+  } else {
+    std::copy(d + limbs, d + n, d);
+  }
+  _digits.resize(n - limbs);
   reduce_zeroes();
+  if (round_up) {
+    size_t i = 0;
+    while (i < _digits.size() && ++_digits[i] == 0) {
+      ++i;
+    }
+    if (i == _digits.size()) {
+      _digits.push_back(1);
+    }
+  }
   return *this;
 }
 
-big_integer big_integer::operator+() const {
+big_integer big_integer::operator+() const& {
   return *this;
 }
 
-big_integer big_integer::operator-() const {
-  big_integer tmp(*this);
-  if (tmp != 0) {
-    tmp._negative = !tmp._negative;
-  }
-  return tmp;
+big_integer big_integer::operator+() && {
+  return std::move(*this);
 }
 
-big_integer big_integer::operator~() const {
-  big_integer tmp(operator-());
-  tmp.add(-1);
-  return tmp;
+big_integer big_integer::operator-() const& {
+  return -big_integer(*this);
+}
+
+big_integer big_integer::operator-() && {
+  _negative = !_negative && !_digits.empty();
+  return std::move(*this);
+}
+
+big_integer big_integer::operator~() const& {
+  return ~big_integer(*this);
+}
+
+big_integer big_integer::operator~() && {
+  add_small(1, false);
+  return -std::move(*this);
 }
 
 big_integer& big_integer::operator++() {
-  return add(1);
+  return add_small(1, false);
 }
 
 big_integer big_integer::operator++(int) {
@@ -413,7 +2355,7 @@ big_integer big_integer::operator++(int) {
 }
 
 big_integer& big_integer::operator--() {
-  return add(-1);
+  return add_small(1, true);
 }
 
 big_integer big_integer::operator--(int) {
@@ -423,98 +2365,701 @@ big_integer big_integer::operator--(int) {
 }
 
 big_integer operator+(const big_integer& a, const big_integer& b) {
-  return big_integer(a) += b;
+  return big_integer(a) + b;
+}
+
+big_integer operator+(big_integer&& a, const big_integer& b) {
+  return std::move(a += b);
+}
+
+big_integer operator+(const big_integer& a, big_integer&& b) {
+  return std::move(b += a);
+}
+
+big_integer operator+(big_integer&& a, big_integer&& b) {
+  return std::move(a += b);
 }
 
 big_integer operator-(const big_integer& a, const big_integer& b) {
-  return big_integer(a) -= b;
+  return big_integer(a) - b;
+}
+
+big_integer operator-(big_integer&& a, const big_integer& b) {
+  return std::move(a -= b);
+}
+
+big_integer operator-(const big_integer& a, big_integer&& b) {
+  return -std::move(b -= a);
+}
+
+big_integer operator-(big_integer&& a, big_integer&& b) {
+  return std::move(a -= b);
 }
 
 big_integer operator*(const big_integer& a, const big_integer& b) {
-  return big_integer(a) *= b;
+  return big_integer(a) * b;
+}
+
+big_integer operator*(big_integer&& a, const big_integer& b) {
+  return std::move(a *= b);
+}
+
+big_integer operator*(const big_integer& a, big_integer&& b) {
+  return std::move(b *= a);
+}
+
+big_integer operator*(big_integer&& a, big_integer&& b) {
+  return std::move(a *= b);
+}
+
+big_integer sqr(const big_integer& a) {
+  if (a._digits.empty()) {
+    return 0;
+  }
+  big_integer::vec result(2 * a._digits.size());
+  loc_kernels::sqr(result.data(), a._digits.data(), a._digits.size());
+  big_integer square(std::move(result));
+  square.reduce_zeroes();
+  return square;
+}
+
+// base = odd * 2^t is raised as odd^exp by left-to-right binary exponentiation and shifted by t * exp at the end.
+// odd^exp has at most bits(odd) * exp bits, so the result buffer is allocated once with room for the shift, and
+// the products alternate between it and a temporary so that the last one lands in the result.
+big_integer pow(const big_integer& base, uint64_t exp) {
+  using loc_kernels::limb;
+  if (!exp) {
+    return 1;
+  }
+  if (base._digits.empty()) {
+    return 0;
+  }
+  const limb* b = base._digits.data();
+  size_t zero_limbs = 0;
+  while (!b[zero_limbs]) {
+    ++zero_limbs;
+  }
+  auto zero_bits = static_cast<unsigned>(std::countr_zero(b[zero_limbs]));
+  size_t on = base._digits.size() - zero_limbs;
+  big_integer::vec odd(b + zero_limbs, b + zero_limbs + on);
+  if (zero_bits) {
+    loc_kernels::rshift(odd.data(), odd.data(), on, zero_bits);
+    on -= !odd[on - 1];
+  }
+  uint64_t odd_bits = (on - 1) * loc_consts::CHUNK_SIZE + std::bit_width(odd[on - 1]);
+  uint64_t shift_bits = zero_limbs * loc_consts::CHUNK_SIZE + zero_bits;
+  if (exp > std::numeric_limits<uint64_t>::max() / (odd_bits + shift_bits)) {
+    throw std::length_error("Result of pow does not fit in memory.");
+  }
+  bool unit = odd_bits == 1;
+  size_t size = unit ? 1 : (odd_bits * exp + loc_consts::CHUNK_SIZE - 1) / loc_consts::CHUNK_SIZE;
+  size_t offset = shift_bits * exp / loc_consts::CHUNK_SIZE;
+  big_integer::vec result(offset + size + 1);
+  // A product may take one limb more than its value needs, so both buffers have a spare one.
+  big_integer::vec temp(unit ? 0 : size + 1);
+
+  limb* x = result.data() + offset;
+  limb* y = temp.data();
+  size_t n = on;
+  if (!unit) {
+    auto top = static_cast<unsigned>(std::bit_width(exp) - 1);
+    if ((top + std::popcount(exp) - 1) % 2) {
+      std::swap(x, y);
+    }
+    std::copy(odd.data(), odd.data() + on, x);
+    for (unsigned i = top; i-- > 0;) {
+      loc_kernels::sqr(y, x, n);
+      n = 2 * n - !y[2 * n - 1];
+      std::swap(x, y);
+      if ((exp >> i) & 1) {
+        loc_kernels::mul(y, x, n, odd.data(), on);
+        n = n + on - !y[n + on - 1];
+        std::swap(x, y);
+      }
+    }
+  } else {
+    x[0] = 1;
+  }
+  if (auto bits = static_cast<unsigned>(shift_bits * exp % loc_consts::CHUNK_SIZE)) {
+    x[n] = loc_kernels::lshift(x, x, n, bits);
+  }
+  big_integer power(std::move(result));
+  power.reduce_zeroes();
+  power._negative = base._negative && (exp & 1);
+  return power;
 }
 
 big_integer operator/(const big_integer& a, const big_integer& b) {
-  return big_integer(a) /= b;
+  return big_integer(a) / b;
+}
+
+big_integer operator/(big_integer&& a, const big_integer& b) {
+  return std::move(a /= b);
 }
 
 big_integer operator%(const big_integer& a, const big_integer& b) {
-  return big_integer(a) %= b;
+  return big_integer(a) % b;
+}
+
+big_integer operator%(big_integer&& a, const big_integer& b) {
+  return std::move(a %= b);
+}
+
+big_integer operator/(big_integer a, const limb_divisor& b) {
+  return std::move(a /= b);
+}
+
+big_integer operator%(const big_integer& a, const limb_divisor& b) {
+  return big_integer(b.divrem(nullptr, a._digits.data(), a._digits.size()), a._negative);
 }
 
 big_integer operator&(const big_integer& a, const big_integer& b) {
-  return big_integer(a) &= b;
+  return big_integer(a) & b;
+}
+
+big_integer operator&(big_integer&& a, const big_integer& b) {
+  return std::move(a &= b);
+}
+
+big_integer operator&(const big_integer& a, big_integer&& b) {
+  return std::move(b &= a);
+}
+
+big_integer operator&(big_integer&& a, big_integer&& b) {
+  return std::move(a &= b);
 }
 
 big_integer operator|(const big_integer& a, const big_integer& b) {
-  return big_integer(a) |= b;
+  return big_integer(a) | b;
+}
+
+big_integer operator|(big_integer&& a, const big_integer& b) {
+  return std::move(a |= b);
+}
+
+big_integer operator|(const big_integer& a, big_integer&& b) {
+  return std::move(b |= a);
+}
+
+big_integer operator|(big_integer&& a, big_integer&& b) {
+  return std::move(a |= b);
 }
 
 big_integer operator^(const big_integer& a, const big_integer& b) {
-  return big_integer(a) ^= b;
+  return big_integer(a) ^ b;
+}
+
+big_integer operator^(big_integer&& a, const big_integer& b) {
+  return std::move(a ^= b);
+}
+
+big_integer operator^(const big_integer& a, big_integer&& b) {
+  return std::move(b ^= a);
+}
+
+big_integer operator^(big_integer&& a, big_integer&& b) {
+  return std::move(a ^= b);
 }
 
 big_integer operator<<(const big_integer& a, int b) {
-  return big_integer(a) <<= b;
+  return big_integer(a) << b;
+}
+
+big_integer operator<<(big_integer&& a, int b) {
+  return std::move(a <<= b);
 }
 
 big_integer operator>>(const big_integer& a, int b) {
-  return big_integer(a) >>= b;
+  return big_integer(a) >> b;
+}
+
+big_integer operator>>(big_integer&& a, int b) {
+  return std::move(a >>= b);
+}
+
+bool operator==(const big_integer& a, const big_integer& b) noexcept {
+  return a._negative == b._negative && a._digits == b._digits;
+}
+
+std::strong_ordering operator<=>(const big_integer& a, const big_integer& b) noexcept {
+  if (a._negative != b._negative) {
+    return a._negative ? std::strong_ordering::less : std::strong_ordering::greater;
+  }
+  int abs = a.abs_compare(b);
+  return (a._negative ? -abs : abs) <=> 0;
+}
+
+limb_divisor::limb_divisor(big_integer::limb d) {
+  if (!d) {
+    throw std::invalid_argument("Expected non-zero divisor while creating limb_divisor.");
+  }
+  _divisor = d;
+  _shift = static_cast<unsigned>(std::countl_zero(d));
+  _normalized = d << _shift;
+  // B^2 - 1 - B * d has ~d as its high limb and all ones below.
+  loc_kernels::double_limb numerator = ~_normalized;
+  numerator = (numerator << loc_consts::CHUNK_SIZE) | loc_consts::CHUNK_MAX;
+  _reciprocal = static_cast<big_integer::limb>(numerator / _normalized);
+}
+
+big_integer::limb limb_divisor::divisor() const noexcept {
+  return _divisor;
+}
+
+// With a shift the dividend is normalized on the fly: the bits shifted out of the top limb start the remainder,
+// which is shifted back at the end.
+big_integer::limb limb_divisor::divrem(big_integer::limb* q, const big_integer::limb* a, size_t n) const noexcept {
+  using loc_kernels::limb;
+  if (!n) {
+    return 0;
+  }
+  if (!_shift) {
+    limb r = 0;
+    for (size_t i = n; i-- > 0;) {
+      limb quotient = loc_kernels::div_2by1(r, a[i], _normalized, _reciprocal);
+      if (q) {
+        q[i] = quotient;
+      }
+    }
+    return r;
+  }
+  limb r = a[n - 1] >> (loc_consts::CHUNK_SIZE - _shift);
+  for (size_t i = n; i-- > 0;) {
+    limb low = a[i] << _shift;
+    if (i) {
+      low |= a[i - 1] >> (loc_consts::CHUNK_SIZE - _shift);
+    }
+    limb quotient = loc_kernels::div_2by1(r, low, _normalized, _reciprocal);
+    if (q) {
+      q[i] = quotient;
+    }
+  }
+  return r >> _shift;
+}
+
+montgomery_context::montgomery_context(const big_integer& modulus) : _modulus(modulus) {
+  if (modulus._negative || modulus._digits.empty() || !(modulus._digits[0] & 1)) {
+    throw std::invalid_argument("Expected odd positive modulus while creating montgomery_context.");
+  }
+  size_t n = modulus._digits.size();
+  const big_integer::limb* m = modulus._digits.data();
+  _inv = loc_kernels::montgomery_inverse(m[0]);
+  loc_kernels::limb_vector r2(2 * n + 1);
+  r2[2 * n] = 1;
+  _r2.resize(n);
+  if (n == 1) {
+    _r2[0] = loc_kernels::mod_1(r2.data(), r2.size(), m[0]);
+  } else {
+    loc_kernels::divrem(nullptr, _r2.data(), r2.data(), r2.size(), m, n);
+  }
+}
+
+const big_integer& montgomery_context::modulus() const noexcept {
+  return _modulus;
+}
+
+// a mod m padded to the limb count of m, negative values wrap around. Only a base outside [0, m) pays for the
+// division, which is not constant-time.
+big_integer::vec montgomery_context::to_residue(const big_integer& a) const {
+  big_integer reduced = a < 0 || a >= _modulus ? a % _modulus : a;
+  if (reduced._negative) {
+    reduced += _modulus;
+  }
+  big_integer::vec residue(std::move(reduced._digits));
+  residue.resize(_modulus._digits.size());
+  return residue;
+}
+
+big_integer montgomery_context::from_montgomery(big_integer::vec& a, bool constant_time) const {
+  size_t n = a.size();
+  loc_kernels::limb_vector t(2 * n);
+  std::copy(a.begin(), a.end(), t.begin());
+  loc_kernels::redc(a.data(), t.data(), _modulus._digits.data(), n, _inv, constant_time);
+  big_integer result(std::move(a));
+  result.reduce_zeroes();
+  return result;
+}
+
+big_integer montgomery_context::powmod(const big_integer& base, const big_integer& exp) const {
+  if (exp._negative) {
+    throw std::invalid_argument("Expected non-negative exponent in powmod.");
+  }
+  if (exp._digits.empty()) {
+    return _modulus == 1 ? 0 : 1;
+  }
+  size_t n = _modulus._digits.size();
+  loc_kernels::montgomery_multiplier mm{_modulus._digits.data(), n, _inv, false};
+  big_integer::vec acc = to_residue(base);
+  mm.multiply(acc.data(), acc.data(), _r2.data());
+
+  // table holds the odd powers base^1, base^3, ..., base^(2^width - 1).
+  const big_integer::limb* e = exp._digits.data();
+  size_t bits = (exp._digits.size() - 1) * loc_consts::CHUNK_SIZE + std::bit_width(exp._digits.back());
+  size_t width = loc_kernels::window_width(bits);
+  loc_kernels::limb_vector table(n << (width - 1));
+  std::copy(acc.begin(), acc.end(), table.begin());
+  if (width > 1) {
+    mm.square(acc.data(), acc.data());
+    for (size_t k = n; k < table.size(); k += n) {
+      mm.multiply(table.data() + k, table.data() + k - n, acc.data());
+    }
+  }
+
+  // Zero bits cost a squaring each, otherwise the longest window [j, i) of at most width bits ending in a one is
+  // consumed at once. The top bit is set, so the first window initializes acc.
+  bool started = false;
+  for (size_t i = bits; i > 0;) {
+    if (!loc_kernels::exponent_bits(e, i - 1, i)) {
+      mm.square(acc.data(), acc.data());
+      --i;
+      continue;
+    }
+    size_t j = i > width ? i - width : 0;
+    while (!loc_kernels::exponent_bits(e, j, j + 1)) {
+      ++j;
+    }
+    const big_integer::limb* power = table.data() + (loc_kernels::exponent_bits(e, j, i) >> 1) * n;
+    if (started) {
+      for (size_t k = j; k < i; ++k) {
+        mm.square(acc.data(), acc.data());
+      }
+      mm.multiply(acc.data(), acc.data(), power);
+    } else {
+      std::copy(power, power + n, acc.data());
+      started = true;
+    }
+    i = j;
+  }
+  return from_montgomery(acc, false);
+}
+
+big_integer montgomery_context::powmod_ct(const big_integer& base, const big_integer& exp) const {
+  if (exp._negative) {
+    throw std::invalid_argument("Expected non-negative exponent in powmod.");
+  }
+  constexpr size_t width = 4;
+  constexpr big_integer::limb table_size = 1 << width;
+  size_t n = _modulus._digits.size();
+  loc_kernels::montgomery_multiplier mm{_modulus._digits.data(), n, _inv, true};
+
+  // table[k] = base^k for every k < 2^width, table[0] is R mod m.
+  loc_kernels::limb_vector table(n * table_size);
+  big_integer::vec x = to_residue(base);
+  big_integer::vec acc(n);
+  acc[0] = 1;
+  mm.multiply(table.data(), _r2.data(), acc.data());
+  mm.multiply(table.data() + n, x.data(), _r2.data());
+  for (size_t k = 2; k < table_size; ++k) {
+    mm.multiply(table.data() + k * n, table.data() + (k - 1) * n, table.data() + n);
+  }
+
+  // Every window of every exponent limb costs width squarings and one product, and the product operand is picked
+  // by reading the whole table under masks.
+  const big_integer::limb* e = exp._digits.data();
+  std::copy(table.begin(), table.begin() + n, acc.begin());
+  for (size_t i = exp._digits.size() * loc_consts::CHUNK_SIZE; i > 0; i -= width) {
+    for (size_t k = 0; k < width; ++k) {
+      mm.square(acc.data(), acc.data());
+    }
+    big_integer::limb value = loc_kernels::exponent_bits(e, i - width, i);
+    std::fill(x.begin(), x.end(), 0);
+    for (big_integer::limb k = 0; k < table_size; ++k) {
+      big_integer::limb mask = big_integer::limb(0) - (k == value);
+      for (size_t l = 0; l < n; ++l) {
+        x[l] |= table[k * n + l] & mask;
+      }
+    }
+    mm.multiply(acc.data(), acc.data(), x.data());
+  }
+  return from_montgomery(acc, true);
+}
+
+big_integer powmod(const big_integer& base, const big_integer& exp, const big_integer& mod) {
+  if (mod._negative || mod._digits.empty()) {
+    throw std::invalid_argument("Expected positive modulus in powmod.");
+  }
+  if (mod._digits[0] & 1) {
+    return montgomery_context(mod).powmod(base, exp);
+  }
+  if (exp._negative) {
+    throw std::invalid_argument("Expected non-negative exponent in powmod.");
+  }
+  // Montgomery form needs an odd modulus, even ones get binary exponentiation with Barrett reduction.
+  barrett_reducer reducer(mod);
+  big_integer x = base;
+  reducer.reduce(x);
+  big_integer result = 1;
+  size_t bits = exp._digits.empty()
+                    ? 0
+                    : (exp._digits.size() - 1) * loc_consts::CHUNK_SIZE + std::bit_width(exp._digits.back());
+  for (size_t i = bits; i-- > 0;) {
+    reducer.mulmod(result, result);
+    if (loc_kernels::exponent_bits(exp._digits.data(), i, i + 1)) {
+      reducer.mulmod(result, x);
+    }
+  }
+  return result;
+}
+
+barrett_reducer::barrett_reducer(const big_integer& modulus) : _modulus(modulus) {
+  if (modulus._negative || modulus._digits.empty()) {
+    throw std::invalid_argument("Expected positive modulus while creating barrett_reducer.");
+  }
+  auto bits = static_cast<int>(2 * modulus._digits.size() * loc_consts::CHUNK_SIZE);
+  _mu = std::move(((big_integer(1) << bits) / modulus)._digits);
+}
+
+const big_integer& barrett_reducer::modulus() const noexcept {
+  return _modulus;
+}
+
+big_integer::limb* barrett_reducer::scratch(size_t size) {
+  if (_scratch.size() < size) {
+    _scratch.resize(size);
+  }
+  return _scratch.data();
+}
+
+// x[0, size) mod m into x[0, n), the limbs above are zeroed. A window of len <= 2n limbs is reduced with
+// q = floor(floor(x / B^(n - 1)) * mu / B^(n + 1)), which is at most 2 below floor(x / m), and x - q * m is taken
+// modulo B^(n + 1). Below BARRETT_SHORT_THRESHOLD only the needed halves of both products are computed. Longer
+// values are reduced by 2n-limb windows from the top, each shortening x by n limbs.
+void barrett_reducer::reduce_limbs(big_integer::limb* x, size_t size) {
+  using loc_kernels::limb;
+  const limb* m = _modulus._digits.data();
+  size_t n = _modulus._digits.size(), mun = _mu.size();
+  if (size < n) {
+    return;
+  }
+  size_t last = size;
+  while (last > 2 * n) {
+    last -= n;
+  }
+  // q2 = q1 * mu, p = q3 * m, r has n + 1 limbs, then the multiplication scratch.
+  auto layout = [n, mun](size_t len) {
+    size_t q1n = len - n + 1, q3n = q1n + mun - n - 1;
+    return std::array<size_t, 4>{q1n, q1n + mun, q3n + n,
+                                 std::max(loc_kernels::mul_ws_itch(q1n, mun), loc_kernels::mul_ws_itch(q3n, n))};
+  };
+  auto itch = [n, &layout](size_t len) {
+    auto [q1n, q2n, pn, wsn] = layout(len);
+    return q2n + pn + n + 1 + wsn;
+  };
+  limb* q2 = scratch(std::max(itch(last), size > 2 * n ? itch(2 * n) : 0));
+
+  auto step = [&](limb* w, size_t len) {
+    auto [q1n, q2n, pn, wsn] = layout(len);
+    limb* p = q2 + q2n;
+    limb* r = p + pn;
+    limb* ws = r + n + 1;
+    if (q1n < loc_consts::BARRETT_SHORT_THRESHOLD) {
+      // Dropping the columns below n - 1 makes q smaller by at most one more.
+      loc_kernels::mul_high_basecase(q2, w + n - 1, q1n, _mu.data(), mun, n - 1);
+      loc_kernels::mul_low_basecase(p, q2 + n + 1, q2n - n - 1, m, n, n + 1);
+    } else {
+      loc_kernels::mul_ws(q2, w + n - 1, q1n, _mu.data(), mun, ws);
+      loc_kernels::mul_ws(p, q2 + n + 1, q2n - n - 1, m, n, ws);
+    }
+    std::copy(w, w + std::min(len, n + 1), r);
+    if (len == n) {
+      r[n] = 0;
+    }
+    loc_kernels::sub(r, r, n + 1, p, n + 1);
+    while (r[n] || loc_kernels::cmp_n(r, m, n) >= 0) {
+      loc_kernels::sub(r, r, n + 1, m, n);
+    }
+    std::copy(r, r + n, w);
+    std::fill(w + n, w + len, 0);
+  };
+  for (; size > 2 * n; size -= n) {
+    step(x + size - 2 * n, 2 * n);
+  }
+  step(x, size);
 }
 
-bool operator==(const big_integer& a, const big_integer& b) {
-  return (a._negative == b._negative) && a.abs_eq(b);
+big_integer& barrett_reducer::reduce(big_integer& x) {
+  size_t n = _modulus._digits.size();
+  reduce_limbs(x._digits.data(), x._digits.size());
+  x._digits.resize(std::min(x._digits.size(), n));
+  x.reduce_zeroes();
+  if (x._negative && !x._digits.empty()) {
+    x._digits.resize(n);
+    loc_kernels::sub_n(x._digits.data(), _modulus._digits.data(), x._digits.data(), n);
+    x.reduce_zeroes();
+  }
+  x._negative = false;
+  return x;
 }
 
-bool operator!=(const big_integer& a, const big_integer& b) {
-  return !(a == b);
+big_integer& barrett_reducer::mulmod(big_integer& a, const big_integer& b) {
+  if (a._digits.empty() || b._digits.empty()) {
+    a._digits.clear();
+    a._negative = false;
+    return a;
+  }
+  size_t an = a._digits.size(), bn = b._digits.size();
+  _product.resize(an + bn);
+  loc_kernels::mul_ws(_product.data(), a._digits.data(), an, b._digits.data(), bn,
+                      scratch(loc_kernels::mul_ws_itch(an, bn)));
+  a._digits.assign(_product.begin(), _product.end());
+  a._negative = a._negative != b._negative;
+  return reduce(a);
 }
 
-bool operator<(const big_integer& a, const big_integer& b) {
-  if (a._negative == b._negative) {
-    return a._negative ? b.abs_less(a) : a.abs_less(b);
+big_integer gcd(const big_integer& a, const big_integer& b) {
+  size_t an = a._digits.size(), bn = b._digits.size();
+  if (std::max(an, bn) <= 64 / loc_consts::CHUNK_SIZE) {
+    return {std::gcd(loc_kernels::to_uint64(a._digits.data(), an), loc_kernels::to_uint64(b._digits.data(), bn)),
+            false};
   }
-  return a._negative;
+  loc_kernels::limb_vector g = loc_kernels::gcd(loc_kernels::limb_vector(a._digits.begin(), a._digits.end()),
+                                                loc_kernels::limb_vector(b._digits.begin(), b._digits.end()),
+                                                nullptr, nullptr);
+  return big_integer(big_integer::vec(g.begin(), g.end()));
 }
 
-bool operator>(const big_integer& a, const big_integer& b) {
-  return b < a;
+big_integer lcm(const big_integer& a, const big_integer& b) {
+  if (a.is_zero() || b.is_zero()) {
+    return 0;
+  }
+  big_integer result = a / gcd(a, b) * b;
+  return result.sign() < 0 ? -std::move(result) : result;
 }
 
-bool operator<=(const big_integer& a, const big_integer& b) {
-  return !(a > b);
+big_integer extended_gcd(const big_integer& a, const big_integer& b, big_integer& x, big_integer& y) {
+  loc_kernels::limb_vector s;
+  bool s_negative = false;
+  loc_kernels::limb_vector g = loc_kernels::gcd(loc_kernels::limb_vector(a._digits.begin(), a._digits.end()),
+                                                loc_kernels::limb_vector(b._digits.begin(), b._digits.end()), &s,
+                                                &s_negative);
+  big_integer divisor(big_integer::vec(g.begin(), g.end()));
+  if (divisor._digits.empty()) {
+    x = 0;
+    y = 0;
+    return divisor;
+  }
+  // x is defined modulo |b| / g, the representative in (-|b| / 2g, |b| / 2g] keeps both coefficients small.
+  big_integer coefficient(big_integer::vec(s.begin(), s.end()));
+  coefficient._negative = s_negative;
+  if (!b._digits.empty()) {
+    big_integer period = big_integer(b._digits) / divisor;
+    coefficient %= period;
+    big_integer twice = coefficient << 1;
+    if (twice > period) {
+      coefficient -= period;
+    } else if (twice <= -period) {
+      coefficient += period;
+    }
+  }
+  if (a._negative) {
+    coefficient = -std::move(coefficient);
+  }
+  big_integer other = b._digits.empty() ? big_integer() : (divisor - a * coefficient) / b;
+  x = std::move(coefficient);
+  y = std::move(other);
+  return divisor;
 }
 
-bool operator>=(const big_integer& a, const big_integer& b) {
-  return !(a < b);
+big_integer invmod(const big_integer& a, const big_integer& mod) {
+  if (mod._negative || mod._digits.empty()) {
+    throw std::invalid_argument("Expected positive modulus in invmod.");
+  }
+  big_integer reduced = a % mod;
+  if (reduced._negative) {
+    reduced += mod;
+  }
+  loc_kernels::limb_vector s;
+  bool s_negative = false;
+  loc_kernels::limb_vector g = loc_kernels::gcd(
+      loc_kernels::limb_vector(reduced._digits.begin(), reduced._digits.end()),
+      loc_kernels::limb_vector(mod._digits.begin(), mod._digits.end()), &s, &s_negative);
+  if (g.size() != 1 || g[0] != 1) {
+    throw std::invalid_argument("Expected value coprime to the modulus in invmod.");
+  }
+  // |s| <= mod, the sign is folded into [0, mod).
+  big_integer result(big_integer::vec(s.begin(), s.end()));
+  result %= mod;
+  if (s_negative && !result._digits.empty()) {
+    result = mod - result;
+  }
+  return result;
 }
 
 std::string to_string(const big_integer& a) {
+  return to_string(a, 10);
+}
+
+std::string to_string(const big_integer& a, int base) {
+  if (base < 2 || base > static_cast<int>(loc_consts::MAX_BASE)) {
+    throw std::invalid_argument("Expected base in range [2, 36] while converting big_integer to string.");
+  }
   if (a._digits.empty()) {
     return "0";
   }
-  bool sign = a._negative && !a.abs_eq(0);
-  big_integer divisible(a);
-  divisible._negative = false;
+  size_t n = a._digits.size();
   std::string result;
-  do {
-    big_integer tmp(divisible.div(loc_consts::TRANSITION_CHUNK));
-    std::string portion(std::to_string(divisible._digits.empty() ? 0 : divisible._digits.front()));
-    std::reverse(portion.begin(), portion.end());
-    portion += std::string(loc_consts::TRANSITION_CHUNK_SIZE - portion.size(), '0');
-    result += portion;
-    divisible = tmp;
-  } while (big_integer(0).abs_less(divisible));
-  while (!result.empty() && result.back() == '0') {
-    result.pop_back();
-  }
-  if (sign) {
-    result += "-";
-  }
-  std::reverse(result.begin(), result.end());
+  if (std::has_single_bit(static_cast<unsigned>(base))) {
+    auto bits = static_cast<unsigned>(std::countr_zero(static_cast<unsigned>(base)));
+    size_t len = ((n - 1) * loc_consts::CHUNK_SIZE + std::bit_width(a._digits.back()) + bits - 1) / bits;
+    result.assign(a._negative + len, '-');
+    loc_kernels::to_pow2_radix(result.data() + a._negative, len, a._digits.data(), n, bits);
+    return result;
+  }
+  loc_kernels::radix rad(base);
+  size_t chunks = rad.chunks_for(n);
+  size_t k = n >= loc_consts::TO_STRING_THRESHOLD ? std::bit_width(chunks - 1) - 1 : 0;
+  loc_kernels::radix_powers powers(rad, k);
+  big_integer::vec scratch(a._digits);
+  result.assign(1 + chunks * rad.digits, '-');
+  loc_kernels::to_radix(result.data() + 1, scratch.data(), n, chunks, rad, powers);
+  size_t begin = result.find_first_not_of('0', 1);
+  if (a._negative) {
+    result[--begin] = '-';
+  }
+  result.erase(0, begin);
   return result;
 }
 
+std::from_chars_result from_chars(const char* first, const char* last, big_integer& value, int base) {
+  if (base < 2 || base > static_cast<int>(loc_consts::MAX_BASE)) {
+    return {first, std::errc::invalid_argument};
+  }
+  auto is_digit = [base](char c) { return loc_kernels::digit_value(c) < static_cast<unsigned>(base); };
+  bool negative = first != last && *first == '-';
+  const char* begin = first + negative;
+  const char* end = std::find_if_not(begin, last, is_digit);
+  if (begin == end) {
+    return {first, std::errc::invalid_argument};
+  }
+  begin = std::find_if(begin, end, [](char c) { return c != '0'; });
+  size_t len = end - begin;
+  loc_kernels::limb_vector digits;
+  if (len && std::has_single_bit(static_cast<unsigned>(base))) {
+    auto bits = static_cast<unsigned>(std::countr_zero(static_cast<unsigned>(base)));
+    digits = loc_kernels::from_pow2_radix(begin, len, bits);
+  } else if (len) {
+    loc_kernels::radix rad(base);
+    size_t chunks = (len + rad.digits - 1) / rad.digits;
+    size_t k = chunks >= loc_consts::FROM_STRING_THRESHOLD ? std::bit_width(chunks - 1) - 1 : 0;
+    loc_kernels::radix_powers powers(rad, k);
+    digits = loc_kernels::from_radix(begin, len, rad, powers);
+  }
+  value._digits.assign(digits.begin(), digits.end());
+  value._negative = negative && !value._digits.empty();
+  return {end, std::errc()};
+}
+
 std::ostream& operator<<(std::ostream& out, const big_integer& a) {
-  return out << to_string(a);
+  std::ios_base::fmtflags flags = out.flags();
+  int base = (flags & std::ios_base::basefield) == std::ios_base::hex   ? 16
+             : (flags & std::ios_base::basefield) == std::ios_base::oct ? 8
+                                                                         : 10;
+  std::string result = to_string(a, base);
+  if (base != 10 && (flags & std::ios_base::showbase) && !a.is_zero()) {
+    result.insert(a.sign() < 0 ? 1 : 0, base == 16 ? "0x" : "0");
+  }
+  if (flags & std::ios_base::uppercase) {
+    std::transform(result.begin(), result.end(), result.begin(), [](char c) { return std::toupper(c); });
+  }
+  return out << result;
 }
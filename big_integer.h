@@ -1,30 +1,57 @@
 #pragma once
 
+#include <charconv>
+#include <compare>
+#include <concepts>
+#include <cstdint>
 #include <iosfwd>
 #include <string>
-#include <vector>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
+#include "small_vector.h"
+
+#if defined(BIG_INTEGER_64BIT_LIMBS) && !defined(__SIZEOF_INT128__)
+#error "64-bit limbs need unsigned __int128 for double-limb intermediates"
+#endif
+
+struct limb_divisor;
+
+template <typename T>
+concept builtin_integer = std::integral<T> && !std::same_as<T, bool>;
+
+// Hot loops run through kernels picked once at startup from the CPU features. The BIG_INTEGER_CPU environment variable
+// (generic, adx, avx2 or avx512) only caps that choice, it never enables a tier the CPU does not support.
 struct big_integer {
 
-  using vec = std::vector<uint32_t>;
-  using vec_ref = std::vector<uint32_t>&;
-  using const_vec_ref = const std::vector<uint32_t>&;
+#ifdef BIG_INTEGER_64BIT_LIMBS
+  using limb = uint64_t;
+#else
+  using limb = uint32_t;
+#endif
+  // Values up to 128 bits are stored inline, which keeps sizeof(big_integer) at 32 bytes.
+  using vec = small_vector<limb, 16 / sizeof(limb)>;
+  using vec_ref = vec&;
+  using const_vec_ref = const vec&;
 
   big_integer();
   big_integer(const big_integer& other);
+  big_integer(big_integer&& other) noexcept;
   big_integer(int a);
   big_integer(unsigned int a);
   big_integer(long a);
   big_integer(unsigned long a);
   big_integer(long long a);
   big_integer(unsigned long long a);
-  explicit big_integer(const std::string& str);
+  explicit big_integer(std::string_view str, int base = 10);
   ~big_integer();
 
   void ensure_size(size_t n);
   void reduce_zeroes() noexcept;
 
   big_integer& operator=(const big_integer& other);
+  big_integer& operator=(big_integer&& other) noexcept;
 
   big_integer& operator+=(const big_integer& rhs);
   big_integer& operator-=(const big_integer& rhs);
@@ -36,12 +63,43 @@ struct big_integer {
   big_integer& operator|=(const big_integer& rhs);
   big_integer& operator^=(const big_integer& rhs);
 
+  template <builtin_integer T>
+  big_integer& operator+=(T rhs) {
+    return add_small(magnitude(rhs), is_negative(rhs));
+  }
+
+  template <builtin_integer T>
+  big_integer& operator-=(T rhs) {
+    return add_small(magnitude(rhs), !is_negative(rhs));
+  }
+
+  template <builtin_integer T>
+  big_integer& operator*=(T rhs) {
+    return mul_small(magnitude(rhs), is_negative(rhs));
+  }
+
+  template <builtin_integer T>
+  big_integer& operator/=(T rhs) {
+    return div_small(magnitude(rhs), is_negative(rhs));
+  }
+
+  template <builtin_integer T>
+  big_integer& operator%=(T rhs) {
+    return assign_small(rem_small(magnitude(rhs)), _negative);
+  }
+
+  // Division by a single limb whose reciprocal is precomputed, see limb_divisor.
+  big_integer& operator/=(const limb_divisor& rhs);
+
   big_integer& operator<<=(int rhs);
   big_integer& operator>>=(int rhs);
 
-  big_integer operator+() const;
-  big_integer operator-() const;
-  big_integer operator~() const;
+  big_integer operator+() const&;
+  big_integer operator+() &&;
+  big_integer operator-() const&;
+  big_integer operator-() &&;
+  big_integer operator~() const&;
+  big_integer operator~() &&;
 
   big_integer& operator++();
   big_integer operator++(int);
@@ -49,63 +107,264 @@ struct big_integer {
   big_integer& operator--();
   big_integer operator--(int);
 
-  friend bool operator==(const big_integer& a, const big_integer& b);
-  friend bool operator!=(const big_integer& a, const big_integer& b);
-  friend bool operator<(const big_integer& a, const big_integer& b);
-  friend bool operator>(const big_integer& a, const big_integer& b);
-  friend bool operator<=(const big_integer& a, const big_integer& b);
-  friend bool operator>=(const big_integer& a, const big_integer& b);
+  // -1, 0 or 1 as the value is negative, zero or positive.
+  int sign() const noexcept;
+  bool is_zero() const noexcept;
+  // Negative, zero or positive as *this is less than, equal to or greater than other.
+  int compare(int64_t other) const noexcept;
+
+  friend bool operator==(const big_integer& a, const big_integer& b) noexcept;
+  friend std::strong_ordering operator<=>(const big_integer& a, const big_integer& b) noexcept;
+
+  // Comparisons with built-in integers look at the limbs directly instead of converting the other side.
+  template <builtin_integer T>
+  friend bool operator==(const big_integer& a, T b) noexcept {
+    return a.compare_small(magnitude(b), is_negative(b)) == 0;
+  }
+
+  template <builtin_integer T>
+  friend std::strong_ordering operator<=>(const big_integer& a, T b) noexcept {
+    return a.compare_small(magnitude(b), is_negative(b)) <=> 0;
+  }
+
+  template <builtin_integer T>
+  friend big_integer operator+(big_integer a, T b) {
+    a += b;
+    return a;
+  }
+
+  template <builtin_integer T>
+  friend big_integer operator+(T a, big_integer b) {
+    b += a;
+    return b;
+  }
+
+  template <builtin_integer T>
+  friend big_integer operator-(big_integer a, T b) {
+    a -= b;
+    return a;
+  }
+
+  template <builtin_integer T>
+  friend big_integer operator-(T a, big_integer b) {
+    return -std::move(b -= a);
+  }
+
+  template <builtin_integer T>
+  friend big_integer operator*(big_integer a, T b) {
+    a *= b;
+    return a;
+  }
+
+  template <builtin_integer T>
+  friend big_integer operator*(T a, big_integer b) {
+    b *= a;
+    return b;
+  }
+
+  template <builtin_integer T>
+  friend big_integer operator/(big_integer a, T b) {
+    a /= b;
+    return a;
+  }
+
+  // The remainder has the sign of the dividend, so it is returned natively only when T can hold it.
+  template <builtin_integer T>
+    requires std::is_signed_v<T>
+  friend T operator%(const big_integer& a, T b) {
+    auto remainder = static_cast<T>(a.rem_small(magnitude(b)));
+    return a._negative ? static_cast<T>(-remainder) : remainder;
+  }
+
+  template <builtin_integer T>
+    requires std::is_unsigned_v<T>
+  friend big_integer operator%(const big_integer& a, T b) {
+    return big_integer(a.rem_small(b), a._negative);
+  }
+
+  // Only reads its operand, but has to beat operator%(big_integer&&, const big_integer&) for temporaries.
+  template <builtin_integer T>
+  friend auto operator%(big_integer&& a, T b) {
+    return static_cast<const big_integer&>(a) % b;
+  }
+
+  // The remainder has the sign of the dividend, like for built-in divisors.
+  friend big_integer operator%(const big_integer& a, const limb_divisor& b);
 
+  friend big_integer sqr(const big_integer& a);
+  friend big_integer pow(const big_integer& base, uint64_t exp);
   friend std::string to_string(const big_integer& a);
+  friend std::string to_string(const big_integer& a, int base);
+  friend std::from_chars_result from_chars(const char* first, const char* last, big_integer& value, int base);
+  friend big_integer powmod(const big_integer& base, const big_integer& exp, const big_integer& mod);
+  friend big_integer gcd(const big_integer& a, const big_integer& b);
+  friend big_integer extended_gcd(const big_integer& a, const big_integer& b, big_integer& x, big_integer& y);
+  friend big_integer invmod(const big_integer& a, const big_integer& mod);
+  friend struct montgomery_context;
+  friend struct barrett_reducer;
 
 private:
-  bool abs_less(const big_integer& other) const;
-  bool abs_eq(const big_integer& other) const;
+  int abs_compare(const big_integer& other) const noexcept;
+  int compare_small(uint64_t magnitude, bool negative) const noexcept;
 
-  big_integer& convert() noexcept;
-  big_integer divide(const big_integer& other);
+  void divide(const big_integer& other, bool quotient);
   big_integer(vec vector);
   big_integer(unsigned long long a, bool sign);
 
-  big_integer& add(int32_t other);
-  big_integer& mul(uint32_t other);
-  big_integer div(uint32_t other);
+  template <typename T>
+  static constexpr bool is_negative(T value) noexcept {
+    if constexpr (std::is_signed_v<T>) {
+      return value < 0;
+    } else {
+      return false;
+    }
+  }
 
-  static big_integer divide(big_integer& a, big_integer b);
+  template <typename T>
+  static constexpr uint64_t magnitude(T value) noexcept {
+    return is_negative(value) ? -static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+  }
+
+  big_integer& assign_small(uint64_t magnitude, bool negative);
+  big_integer& add_small(uint64_t magnitude, bool negative);
+  big_integer& mul_small(uint64_t magnitude, bool negative);
+  big_integer& div_small(uint64_t magnitude, bool negative);
+  uint64_t rem_small(uint64_t magnitude) const;
+
+  big_integer& accumulate(const big_integer& other, bool subtract);
 
-  template <typename F>
-  big_integer& add_sub_chunk(uint32_t chunk, const F& f);
   template <typename F>
   inline big_integer& binary_bit_operation(const big_integer& other, const F& f);
   template <typename F>
   static void vector_bit_f(const big_integer& a, const big_integer& b, big_integer& result, const F& f);
-  template <typename F>
-  static void vector_f(const_vec_ref a, const_vec_ref b, vec_ref result, const F& f);
 
 private:
   vec _digits;
   bool _negative;
 };
 
+// Division by an invariant limb d as in Moller and Granlund, "Improved division by invariant integers". The
+// reciprocal of d shifted to have its top bit set is computed once, after that every quotient limb costs two
+// multiplications and a couple of corrections instead of a hardware division.
+struct limb_divisor {
+  explicit limb_divisor(big_integer::limb d);
+
+  big_integer::limb divisor() const noexcept;
+
+  // q = a / d for n-limb a, returns a % d. q may coincide with a or be null when only the remainder is needed.
+  big_integer::limb divrem(big_integer::limb* q, const big_integer::limb* a, size_t n) const noexcept;
+
+private:
+  big_integer::limb _divisor;
+  big_integer::limb _normalized;
+  big_integer::limb _reciprocal;
+  unsigned _shift;
+};
+
+// Arithmetic modulo a fixed odd modulus m in Montgomery form. The context computes -m^-1 mod B and R^2 mod m for
+// R = B^n, n being the limb count of m, once, so that every reduction afterwards is a multiply-and-add pass.
+struct montgomery_context {
+  explicit montgomery_context(const big_integer& modulus);
+
+  const big_integer& modulus() const noexcept;
+
+  // base^exp mod m in [0, m) by sliding-window exponentiation, exp must be non-negative.
+  big_integer powmod(const big_integer& base, const big_integer& exp) const;
+  // The same with a fixed 4-bit window: the sequence of limb operations and table reads depends on the limb counts
+  // of m and exp only, never on the exponent bits. Only the exponent is protected: the base is compared with m and,
+  // when it lies outside [0, m), reduced by an ordinary variable-time division first.
+  big_integer powmod_ct(const big_integer& base, const big_integer& exp) const;
+
+private:
+  big_integer::vec to_residue(const big_integer& a) const;
+  big_integer from_montgomery(big_integer::vec& a, bool constant_time) const;
+
+  big_integer _modulus;
+  big_integer::vec _r2;
+  big_integer::limb _inv;
+};
+
+// Repeated reduction modulo a fixed positive modulus m of any parity. The reciprocal mu = B^2n / m for an n-limb m
+// is computed once, then every step of reduce costs two multiplications and at most two subtractions of m. The
+// reducer keeps its scratch buffers between calls, so it is meant to be owned by one thread.
+struct barrett_reducer {
+  explicit barrett_reducer(const big_integer& modulus);
+
+  const big_integer& modulus() const noexcept;
+
+  // x = x mod m in [0, m). Unless m is long enough for Toom-Cook products, nothing is allocated once x and the
+  // reducer have seen operands of this size.
+  big_integer& reduce(big_integer& x);
+  // a = a * b mod m in [0, m), with the same allocation guarantee.
+  big_integer& mulmod(big_integer& a, const big_integer& b);
+
+private:
+  big_integer::limb* scratch(size_t size);
+  void reduce_limbs(big_integer::limb* x, size_t size);
+
+  big_integer _modulus;
+  big_integer::vec _mu;
+  big_integer::vec _product;
+  big_integer::vec _scratch;
+};
+
 big_integer operator+(const big_integer& a, const big_integer& b);
+big_integer operator+(big_integer&& a, const big_integer& b);
+big_integer operator+(const big_integer& a, big_integer&& b);
+big_integer operator+(big_integer&& a, big_integer&& b);
 big_integer operator-(const big_integer& a, const big_integer& b);
+big_integer operator-(big_integer&& a, const big_integer& b);
+big_integer operator-(const big_integer& a, big_integer&& b);
+big_integer operator-(big_integer&& a, big_integer&& b);
 big_integer operator*(const big_integer& a, const big_integer& b);
+big_integer operator*(big_integer&& a, const big_integer& b);
+big_integer operator*(const big_integer& a, big_integer&& b);
+big_integer operator*(big_integer&& a, big_integer&& b);
+big_integer sqr(const big_integer& a);
+// base^exp, 0^0 is 1. The power of two dividing base becomes a single shift of the result.
+big_integer pow(const big_integer& base, uint64_t exp);
+// base^exp mod mod in [0, mod), mod must be positive and exp non-negative. Odd moduli go through a
+// montgomery_context and even ones through a barrett_reducer, build one explicitly to reuse it across calls.
+big_integer powmod(const big_integer& base, const big_integer& exp, const big_integer& mod);
+// Greatest common divisor of |a| and |b|, gcd(0, 0) is 0. Lehmer steps on the top two limbs for short operands,
+// a subquadratic half GCD for long ones.
+big_integer gcd(const big_integer& a, const big_integer& b);
+// Least common multiple of |a| and |b|, 0 when either of them is 0.
+big_integer lcm(const big_integer& a, const big_integer& b);
+// Returns g = gcd(a, b) and stores Bezout coefficients with a * x + b * y = g. Unless b is 0 or |a| = |b|, x is the
+// one with |x| <= |b| / 2g, which keeps |y| <= |a| / 2g + 1. x and y may alias a and b.
+big_integer extended_gcd(const big_integer& a, const big_integer& b, big_integer& x, big_integer& y);
+// a^-1 mod mod in [0, mod) for a positive mod, throws std::invalid_argument when a and mod are not coprime.
+big_integer invmod(const big_integer& a, const big_integer& mod);
 big_integer operator/(const big_integer& a, const big_integer& b);
+big_integer operator/(big_integer&& a, const big_integer& b);
+big_integer operator/(big_integer a, const limb_divisor& b);
 big_integer operator%(const big_integer& a, const big_integer& b);
+big_integer operator%(big_integer&& a, const big_integer& b);
+big_integer operator%(const big_integer& a, const limb_divisor& b);
 
 big_integer operator&(const big_integer& a, const big_integer& b);
+big_integer operator&(big_integer&& a, const big_integer& b);
+big_integer operator&(const big_integer& a, big_integer&& b);
+big_integer operator&(big_integer&& a, big_integer&& b);
 big_integer operator|(const big_integer& a, const big_integer& b);
+big_integer operator|(big_integer&& a, const big_integer& b);
+big_integer operator|(const big_integer& a, big_integer&& b);
+big_integer operator|(big_integer&& a, big_integer&& b);
 big_integer operator^(const big_integer& a, const big_integer& b);
+big_integer operator^(big_integer&& a, const big_integer& b);
+big_integer operator^(const big_integer& a, big_integer&& b);
+big_integer operator^(big_integer&& a, big_integer&& b);
 
 big_integer operator<<(const big_integer& a, int b);
+big_integer operator<<(big_integer&& a, int b);
 big_integer operator>>(const big_integer& a, int b);
+big_integer operator>>(big_integer&& a, int b);
 
-bool operator==(const big_integer& a, const big_integer& b);
-bool operator!=(const big_integer& a, const big_integer& b);
-bool operator<(const big_integer& a, const big_integer& b);
-bool operator>(const big_integer& a, const big_integer& b);
-bool operator<=(const big_integer& a, const big_integer& b);
-bool operator>=(const big_integer& a, const big_integer& b);
+bool operator==(const big_integer& a, const big_integer& b) noexcept;
+std::strong_ordering operator<=>(const big_integer& a, const big_integer& b) noexcept;
 
 std::string to_string(const big_integer& a);
+std::string to_string(const big_integer& a, int base);
+std::from_chars_result from_chars(const char* first, const char* last, big_integer& value, int base = 10);
 std::ostream& operator<<(std::ostream& out, const big_integer& a);
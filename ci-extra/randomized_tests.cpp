@@ -180,6 +180,20 @@ TEST(correctness_random, mul) {
   }
 }
 
+TEST(correctness_random, mul_long) {
+  std::default_random_engine rng(42);
+  for (size_t sz : {MAX_SIZE * 4, MAX_SIZE * 16, MAX_SIZE * 64, MAX_SIZE * 512}) {
+    for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS; ++itn) {
+      big_integer_gmp a, b;
+      a.random(sz, rng);
+      b.random(itn % 2 == 0 ? sz : sz / (itn + 1), rng);
+      big_integer_gmp c = a * b;
+      big_integer R = big_integer(to_string(a)) * big_integer(to_string(b));
+      EXPECT_EQ(to_string(c), to_string(R));
+    }
+  }
+}
+
 TEST(correctness_random, div) {
   std::default_random_engine rng(322);
   for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS; ++itn) {
@@ -212,6 +226,20 @@ TEST(correctness_random, mod) {
   }
 }
 
+TEST(correctness_random, divmod_long) {
+  std::default_random_engine rng(322);
+  for (size_t sz : {MAX_SIZE * 4, MAX_SIZE * 16}) {
+    for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS; ++itn) {
+      big_integer_gmp a, b;
+      a.random(sz, rng);
+      b.random(sz / (itn + 2), rng);
+      big_integer A(to_string(a)), B(to_string(b));
+      EXPECT_EQ(to_string(a / b), to_string(A / B));
+      EXPECT_EQ(to_string(a % b), to_string(A % B));
+    }
+  }
+}
+
 TEST(correctness_random, bitwise) {
   std::default_random_engine rng(42);
   for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS; ++itn) {
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Vector of trivially copyable elements keeping up to N of them inline, so short values never touch the heap.
+// Once grown, storage is kept until destruction, like std::vector.
+template <typename T, size_t N>
+class small_vector {
+  static_assert(std::is_trivially_copyable_v<T> && N > 0);
+
+public:
+  using value_type = T;
+  using size_type = size_t;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  small_vector() noexcept {}
+
+  explicit small_vector(size_t n, T value = T()) {
+    assign(n, value);
+  }
+
+  template <std::input_iterator It>
+  small_vector(It first, It last) {
+    assign(first, last);
+  }
+
+  small_vector(const small_vector& other) {
+    assign(other.begin(), other.end());
+  }
+
+  small_vector(small_vector&& other) noexcept {
+    steal(other);
+  }
+
+  small_vector& operator=(const small_vector& other) {
+    if (this != &other) {
+      assign(other.begin(), other.end());
+    }
+    return *this;
+  }
+
+  small_vector& operator=(small_vector&& other) noexcept {
+    if (this != &other) {
+      release();
+      steal(other);
+    }
+    return *this;
+  }
+
+  ~small_vector() {
+    release();
+  }
+
+  size_t size() const noexcept {
+    return _size;
+  }
+
+  size_t capacity() const noexcept {
+    return _capacity;
+  }
+
+  bool empty() const noexcept {
+    return _size == 0;
+  }
+
+  T* data() noexcept {
+    return is_inline() ? _inline : _heap;
+  }
+
+  const T* data() const noexcept {
+    return is_inline() ? _inline : _heap;
+  }
+
+  T& operator[](size_t i) noexcept {
+    return data()[i];
+  }
+
+  const T& operator[](size_t i) const noexcept {
+    return data()[i];
+  }
+
+  T& front() noexcept {
+    return data()[0];
+  }
+
+  const T& front() const noexcept {
+    return data()[0];
+  }
+
+  T& back() noexcept {
+    return data()[_size - 1];
+  }
+
+  const T& back() const noexcept {
+    return data()[_size - 1];
+  }
+
+  iterator begin() noexcept {
+    return data();
+  }
+
+  const_iterator begin() const noexcept {
+    return data();
+  }
+
+  iterator end() noexcept {
+    return data() + _size;
+  }
+
+  const_iterator end() const noexcept {
+    return data() + _size;
+  }
+
+  void reserve(size_t n) {
+    if (n > _capacity) {
+      grow(n, _size);
+    }
+  }
+
+  void resize(size_t n, T value = T()) {
+    if (n > _size) {
+      reserve(n);
+      std::fill(data() + _size, data() + n, value);
+    }
+    _size = static_cast<uint32_t>(n);
+  }
+
+  void clear() noexcept {
+    _size = 0;
+  }
+
+  void push_back(T value) {
+    if (_size == _capacity) {
+      grow(_size + 1, _size);
+    }
+    data()[_size++] = value;
+  }
+
+  void pop_back() noexcept {
+    --_size;
+  }
+
+  void assign(size_t n, T value) {
+    clear();
+    resize(n, value);
+  }
+
+  template <std::input_iterator It>
+  void assign(It first, It last) {
+    auto n = static_cast<size_t>(std::distance(first, last));
+    if (n > _capacity) {
+      grow(n, 0);
+    }
+    std::copy(first, last, data());
+    _size = static_cast<uint32_t>(n);
+  }
+
+  void swap(small_vector& other) noexcept {
+    small_vector tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+  friend bool operator==(const small_vector& a, const small_vector& b) noexcept {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+  }
+
+private:
+  bool is_inline() const noexcept {
+    return _capacity == N;
+  }
+
+  // Moves to a heap block of at least n elements, keeping the first `keep` of them. Every size above the capacity
+  // passes through here, so the check keeps the 32-bit _size and _capacity from wrapping. Doubling saturates at the
+  // limit, the new capacity is always above the old one and never equals N.
+  void grow(size_t n, size_t keep) {
+    constexpr size_t max_capacity = std::numeric_limits<uint32_t>::max();
+    if (n > max_capacity) {
+      throw std::length_error("small_vector can not hold more than 2^32 - 1 elements.");
+    }
+    size_t capacity = std::max(n, std::min(2 * static_cast<size_t>(_capacity), max_capacity));
+    T* heap = new T[capacity];
+    std::copy(data(), data() + keep, heap);
+    release();
+    _heap = heap;
+    _capacity = static_cast<uint32_t>(capacity);
+  }
+
+  void release() noexcept {
+    if (!is_inline()) {
+      delete[] _heap;
+      _capacity = N;
+    }
+  }
+
+  void steal(small_vector& other) noexcept {
+    if (other.is_inline()) {
+      std::copy(other._inline, other._inline + other._size, _inline);
+    } else {
+      _heap = other._heap;
+      _capacity = other._capacity;
+      other._capacity = N;
+    }
+    _size = other._size;
+    other._size = 0;
+  }
+
+  union {
+    T* _heap;
+    T _inline[N];
+  };
+  uint32_t _size = 0;
+  uint32_t _capacity = N;
+};
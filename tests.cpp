@@ -4,9 +4,15 @@
 #include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <compare>
 #include <cstdlib>
 #include <limits>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace {
 
@@ -92,6 +98,94 @@ TEST(correctness, ctor_invalid_string) {
   EXPECT_THROW(big_integer("++5"), std::invalid_argument);
 }
 
+TEST(correctness, inline_storage) {
+  EXPECT_LE(sizeof(big_integer), 32);
+
+  big_integer small = std::numeric_limits<uint64_t>::max();
+  big_integer large = small * small * small;
+  big_integer copy = large;
+  copy = small;
+  EXPECT_EQ(copy, small);
+  copy = large;
+  EXPECT_EQ(copy, large);
+  copy /= small;
+  copy /= small;
+  EXPECT_EQ(copy, small);
+  copy *= small;
+  copy *= small;
+  EXPECT_EQ(copy, large);
+}
+
+TEST(correctness, small_vector_length_limit) {
+  // Sizes are stored in 32 bits, anything longer is rejected before allocating.
+  using vector = small_vector<uint32_t, 4>;
+  constexpr size_t too_long = size_t(std::numeric_limits<uint32_t>::max()) + 1;
+  EXPECT_THROW(vector(too_long, 0), std::length_error);
+  vector v(3, 7);
+  EXPECT_THROW(v.reserve(too_long), std::length_error);
+  EXPECT_THROW(v.resize(too_long), std::length_error);
+  EXPECT_EQ(3, v.size());
+  EXPECT_EQ(4, v.capacity());
+
+  v.resize(100, 1);
+  EXPECT_EQ(100, v.size());
+  EXPECT_EQ(1, v.back());
+  EXPECT_EQ(7, v.front());
+}
+
+#ifdef BIG_INTEGER_64BIT_LIMBS
+TEST(correctness, limb_64bit) {
+  static_assert(sizeof(big_integer::limb) == 8);
+  EXPECT_EQ(32, sizeof(big_integer));
+
+  // 2^64 - 1 fills exactly one limb, every step below carries or borrows across a limb boundary.
+  big_integer max = std::numeric_limits<uint64_t>::max();
+  big_integer two_64 = max + 1;
+  EXPECT_EQ(big_integer(1) << 64, two_64);
+  EXPECT_EQ("18446744073709551616", to_string(two_64));
+  EXPECT_EQ(max, two_64 - 1);
+  EXPECT_EQ(-two_64, -max - 1);
+  EXPECT_EQ((big_integer(1) << 128) - (big_integer(1) << 65) + 1, max * max);
+  EXPECT_EQ(big_integer(1) << 128, (two_64 << 64) - 1 + 1);
+  EXPECT_EQ(max, (max * max + 2 * max) / two_64);
+  EXPECT_EQ(max, (max * max + 2 * max) % two_64);
+}
+#endif
+
+TEST(correctness, move_ctor) {
+  static_assert(std::is_nothrow_move_constructible_v<big_integer>);
+  static_assert(std::is_nothrow_move_assignable_v<big_integer>);
+
+  big_integer a("-123456789012345678901234567890");
+  big_integer b = std::move(a);
+  EXPECT_EQ(b, big_integer("-123456789012345678901234567890"));
+  a = std::move(b);
+  EXPECT_EQ(a, big_integer("-123456789012345678901234567890"));
+  a = std::move(a);
+  EXPECT_EQ(a, big_integer("-123456789012345678901234567890"));
+}
+
+TEST(correctness, rvalue_operators) {
+  big_integer a("123456789012345678901234567890");
+  big_integer b("-98765432109876543210");
+  big_integer sum = a + b, difference = a - b, product = a * b;
+
+  EXPECT_EQ(big_integer(a) + b, sum);
+  EXPECT_EQ(a + big_integer(b), sum);
+  EXPECT_EQ(big_integer(a) + big_integer(b), sum);
+  EXPECT_EQ(big_integer(a) - b, difference);
+  EXPECT_EQ(a - big_integer(b), difference);
+  EXPECT_EQ(big_integer(a) - big_integer(b), difference);
+  EXPECT_EQ(a * big_integer(b), product);
+  EXPECT_EQ(big_integer(product) / b, a);
+  EXPECT_EQ(big_integer(product) % a, 0);
+  EXPECT_EQ(big_integer(a) % 1000, 890);
+  EXPECT_EQ((big_integer(a) ^ big_integer(b)) ^ b, a);
+  EXPECT_EQ(big_integer(a) << 3 >> 3, a);
+  EXPECT_EQ(-big_integer(b), -b);
+  EXPECT_EQ(1 - (a * 2 + 1) / 2, 1 - a);
+}
+
 TEST(correctness, assignment_operator) {
   big_integer a = 4;
   big_integer b = 7;
@@ -289,6 +383,44 @@ TEST(correctness, div_return_value) {
   EXPECT_EQ(25, a);
 }
 
+TEST(correctness, builtin_operands) {
+  big_integer a("-123456789012345678901234567890");
+  int64_t b = std::numeric_limits<int64_t>::min();
+  uint64_t c = std::numeric_limits<uint64_t>::max();
+
+  EXPECT_EQ(a + b, a + big_integer(b));
+  EXPECT_EQ(b + a, a + big_integer(b));
+  EXPECT_EQ(a - c, a - big_integer(c));
+  EXPECT_EQ(c - a, big_integer(c) - a);
+  EXPECT_EQ(a * b, a * big_integer(b));
+  EXPECT_EQ(c * a, a * big_integer(c));
+  EXPECT_EQ(a / b, a / big_integer(b));
+  EXPECT_EQ(a / 7u, a / big_integer(7));
+  EXPECT_EQ(a % c, a % big_integer(c));
+  EXPECT_EQ(a + 0, a);
+  EXPECT_EQ(a * 0, 0);
+}
+
+TEST(correctness, builtin_remainder) {
+  big_integer a("-123456789012345678901234567890");
+  int r = a % 1000;
+  int64_t r64 = a % std::numeric_limits<int64_t>::max();
+
+  EXPECT_EQ(r, -890);
+  EXPECT_EQ(r64, a % big_integer(std::numeric_limits<int64_t>::max()));
+  EXPECT_EQ(big_integer(-7) % -7, 0);
+
+  a %= -1000000007;
+  EXPECT_EQ(a, big_integer("-123456789012345678901234567890") % big_integer(1000000007));
+}
+
+TEST(correctness, builtin_return_value) {
+  big_integer a = 5;
+  (a *= 2) += 3u;
+  (a -= 1LL) /= 3;
+  EXPECT_EQ(a, 4);
+}
+
 TEST(correctness, unary_plus) {
   big_integer a = 123;
   big_integer b = +a;
@@ -313,6 +445,34 @@ TEST(correctness, negation_int_min) {
   EXPECT_EQ(b - 1, std::numeric_limits<int>::max());
 }
 
+TEST(correctness, sign_and_compare) {
+  big_integer a("-123456789012345678901234567890");
+  big_integer b("123456789012345678901234567890");
+  big_integer zero;
+
+  EXPECT_EQ(-1, a.sign());
+  EXPECT_EQ(1, b.sign());
+  EXPECT_EQ(0, zero.sign());
+  EXPECT_TRUE(zero.is_zero());
+  EXPECT_FALSE(a.is_zero());
+  EXPECT_TRUE(big_integer(-0).is_zero());
+
+  EXPECT_LT(a.compare(std::numeric_limits<int64_t>::min()), 0);
+  EXPECT_GT(b.compare(std::numeric_limits<int64_t>::max()), 0);
+  EXPECT_EQ(0, big_integer(-42).compare(-42));
+  EXPECT_LT(big_integer(-43).compare(-42), 0);
+  EXPECT_GT(big_integer(5).compare(-42), 0);
+  EXPECT_EQ(0, zero.compare(0));
+
+  EXPECT_EQ(std::strong_ordering::less, a <=> b);
+  EXPECT_EQ(std::strong_ordering::greater, a <=> b - b - b - 1);
+  EXPECT_EQ(std::strong_ordering::equal, b <=> -a);
+  EXPECT_EQ(std::strong_ordering::greater, b <=> std::numeric_limits<uint64_t>::max());
+  EXPECT_EQ(std::strong_ordering::less, 0 <=> b);
+  EXPECT_TRUE(a < 0 && 0 < b && zero == 0 && 0u == zero && zero <= 0 && zero >= 0);
+  EXPECT_TRUE(big_integer(std::numeric_limits<uint64_t>::max()) == std::numeric_limits<uint64_t>::max());
+}
+
 TEST(correctness, increment) {
   big_integer a = 42;
   big_integer pre = ++a;
@@ -331,6 +491,30 @@ TEST(correctness, decrement) {
   EXPECT_EQ(41, post);
 }
 
+TEST(correctness, increment_carry) {
+  big_integer a = (big_integer(1) << 256) - 2;
+
+  EXPECT_EQ((big_integer(1) << 256) - 1, ++a);
+  EXPECT_EQ(big_integer(1) << 256, ++a);
+  EXPECT_EQ((big_integer(1) << 256) - 1, --a);
+
+  big_integer b = 1;
+  EXPECT_EQ(0, --b);
+  EXPECT_EQ(-1, --b);
+  EXPECT_EQ(0, ++b);
+  EXPECT_EQ(1, ++b);
+}
+
+TEST(correctness, not_long) {
+  big_integer a = (big_integer(1) << 256) - 1;
+
+  EXPECT_EQ(-(big_integer(1) << 256), ~a);
+  EXPECT_EQ(a, ~~a);
+  EXPECT_EQ(-1, ~big_integer(0));
+  EXPECT_EQ(a, ~(-(big_integer(1) << 256)));
+  EXPECT_EQ(-(big_integer(1) << 256), ~std::move(a));
+}
+
 TEST(correctness, and_) {
   big_integer a = 0x55;
   big_integer b = 0xaa;
@@ -427,6 +611,30 @@ TEST(correctness, xor_return_value) {
   EXPECT_EQ(2, a);
 }
 
+TEST(correctness, bitwise_long) {
+  big_integer a("123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890");
+  big_integer b("987654321098765432109876543210987654321");
+
+  EXPECT_EQ((a | b), (a ^ b) + (a & b));
+  EXPECT_EQ((b | a) - (b & a), a ^ b);
+  EXPECT_EQ(a ^ b ^ b, a);
+  EXPECT_EQ(a & (a | b), a);
+  EXPECT_EQ((a << 1000) & (a << 1000) & a, a & (a << 1000));
+  EXPECT_EQ(((a << 3001) | b) >> 3001, a);
+}
+
+TEST(correctness, bitwise_long_signed) {
+  big_integer a("-123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890");
+  big_integer b = big_integer("987654321098765432109876543210987654321") << 500;
+
+  EXPECT_EQ(a & b, b - (~a & b));
+  EXPECT_EQ(a | b, ~(~a & ~b));
+  EXPECT_EQ(a ^ b, (a | b) - (a & b));
+  EXPECT_EQ(-b & -b, -b);
+  EXPECT_EQ(-b ^ b, -(big_integer(1) << 501));
+  EXPECT_EQ((-b | b) & ~(a ^ -a), -(big_integer(2) << 500) & ~(a ^ -a));
+}
+
 TEST(correctness, not_) {
   big_integer a = 0xaa;
   big_integer b = ~a;
@@ -515,6 +723,35 @@ TEST(correctness, add_long_signed2) {
   EXPECT_EQ(c, a + b);
 }
 
+TEST(correctness, add_sub_self) {
+  big_integer a("-123456789012345678901234567890123456789012345678901234567890");
+  big_integer b = a;
+
+  a += a;
+  EXPECT_EQ(b * 2, a);
+  a -= a;
+  EXPECT_EQ(0, a);
+  EXPECT_EQ(big_integer(0), -a);
+}
+
+TEST(correctness, add_sub_carry_chain) {
+  big_integer one = 1;
+  big_integer a = (one << 3200) - one;
+  big_integer b = a;
+
+  for (int i = 0; i < 1000; ++i) {
+    a += one;
+    a -= one;
+  }
+  EXPECT_EQ(b, a);
+  a += one;
+  EXPECT_EQ(big_integer(1) << 3200, a);
+  a -= big_integer(1) << 3200;
+  EXPECT_EQ(0, a);
+  a -= b;
+  EXPECT_EQ(-b, a);
+}
+
 TEST(correctness, add_long_pow2) {
   big_integer a("18446744073709551616");
   big_integer b("-18446744073709551616");
@@ -582,6 +819,77 @@ TEST(correctness, mul_long_pow2) {
   EXPECT_EQ(c, b * b);
 }
 
+TEST(correctness, mul_long_all_ones) {
+  for (int bits : {100, 1000, 5000, 40000}) {
+    big_integer a = (big_integer(1) << bits) - 1;
+    big_integer b = (big_integer(1) << (bits / 3)) - 1;
+    EXPECT_EQ((big_integer(1) << (2 * bits)) - (big_integer(1) << (bits + 1)) + 1, a * a);
+    EXPECT_EQ((big_integer(1) << (bits + bits / 3)) - (big_integer(1) << bits) - (big_integer(1) << (bits / 3)) + 1,
+              a * b);
+  }
+}
+
+TEST(correctness, mul_toom_unbalanced) {
+  // Operands just above TOOM_THRESHOLD and twice TOOM_THRESHOLD limbs, multiplied by ones 1, 1.5, 2, 3.5 and 5.5
+  // times longer: Toom-3, Toom-2.5, Toom-3.5 and products cut into Toom-3.5 blocks with a shorter last block.
+  for (int b_bits : {12832, 25632}) {
+    big_integer b = (big_integer(1) << b_bits) - (big_integer(1) << (b_bits / 3)) - 1;
+    for (int ratio : {2, 3, 4, 7, 11}) {
+      int a_bits = b_bits * ratio / 2 + 17;
+      big_integer a = ((big_integer(1) << a_bits) - 1) / 3;
+      int split = a_bits / 3;
+      big_integer a_high = a >> split;
+      big_integer a_low = a - (a_high << split);
+      big_integer product = a * b;
+      EXPECT_EQ((a_high * b << split) + a_low * b, product);
+      EXPECT_EQ(product + a, a * (b + 1));
+      EXPECT_EQ(product - b, (a - 1) * b);
+    }
+  }
+}
+
+TEST(correctness, mul_huge) {
+  big_integer a = 3;
+  big_integer b;
+  for (int i = 0; i < 18; ++i) {
+    b = a;
+    a *= a;
+  }
+  big_integer c = a * b;
+  EXPECT_EQ(a * a, c * b);
+  EXPECT_EQ(c * c, a * a * a);
+}
+
+TEST(correctness, sqr) {
+  EXPECT_EQ(0, sqr(big_integer()));
+  EXPECT_EQ(25, sqr(big_integer(-5)));
+
+  big_integer a("-12345678901234567890123456789012345678901234567890");
+  big_integer b = a * (a - 1) + a;
+  EXPECT_EQ(b, sqr(a));
+
+  for (int bits : {1000, 5000, 40000, 300000}) {
+    big_integer c = (big_integer(1) << bits) - 1;
+    big_integer d = c;
+    EXPECT_EQ(c * (d - 1) + c, sqr(c));
+    EXPECT_EQ(sqr(c), c * d);
+    c *= c;
+    EXPECT_EQ(c, d * d);
+  }
+}
+
+TEST(correctness, sqr_zero_evaluation) {
+  // Split into three parts of 9600 bits each, a and b evaluate to zero at -1 in Toom-3.
+  big_integer x = big_integer(1) << 9600;
+  big_integer a = ((x - 2) * x + x - 1) * x + 1;
+  big_integer b = ((x - 3) * x + x - 1) * x + 2;
+  big_integer a_high = a >> 9600;
+  EXPECT_EQ(a * (a - 1) + a, sqr(a));
+  EXPECT_EQ((a_high * a << 9600) + a, a * a);
+  EXPECT_EQ(a * (b - 1) + a, a * b);
+  EXPECT_EQ((a_high * b << 9600) + b, a * b);
+}
+
 TEST(correctness, div_0_long) {
   big_integer a;
   big_integer b("100000000000000000000000000000000000000000000000000000000000");
@@ -615,6 +923,233 @@ TEST(correctness, div_long_signed2) {
   EXPECT_EQ(c, a / b);
 }
 
+TEST(correctness, div_self) {
+  big_integer a("-1234567890123456789012345678901234567890");
+  big_integer b = a;
+  a /= a;
+  b %= b;
+  EXPECT_EQ(1, a);
+  EXPECT_EQ(0, b);
+}
+
+TEST(correctness, div_long_all_ones) {
+  for (int a_bits : {64, 96, 160, 1024, 4000}) {
+    for (int b_bits : {1, 32, 33, 64, 96, 999}) {
+      big_integer a = (big_integer(1) << a_bits) - 1;
+      big_integer b = (big_integer(1) << b_bits) - 1;
+      big_integer q = a / b;
+      big_integer r = a % b;
+      EXPECT_EQ(a, q * b + r);
+      EXPECT_TRUE(0 <= r && r < b);
+    }
+  }
+}
+
+TEST(correctness, div_mid_sized) {
+  // Divisors and quotients from DIV_THRESHOLD to a few hundred limbs go through the recursive division, whose block
+  // products take their scratch from the division buffer.
+  for (int b_bits : {64 * 60, 64 * 80 + 5, 64 * 100, 64 * 150 - 3, 64 * 200}) {
+    big_integer all_ones = (big_integer(1) << b_bits) - 1;
+    big_integer b = all_ones / 7 + 12345;
+    for (big_integer a : {b * b + all_ones, (b << (b_bits / 2)) * b * 3 - 1, all_ones * all_ones, -b * b * 5 - 17}) {
+      big_integer q = a / b;
+      big_integer r = a % b;
+      EXPECT_EQ(a, q * b + r);
+      EXPECT_TRUE(r <= 0 ? -r < b : r < b);
+      EXPECT_EQ(q, (a - r) / b);
+    }
+  }
+}
+
+TEST(correctness, div_huge) {
+  for (int bits : {3000, 10000, 100000}) {
+    big_integer a = (big_integer(1) << bits) - 1;
+    big_integer b = (big_integer(1) << (bits / 2)) + 12345;
+    big_integer c = a * a + b;
+    EXPECT_EQ(a, c / a);
+    EXPECT_EQ(b, c % a);
+    EXPECT_EQ(-a, -c / a);
+    EXPECT_EQ(-b, -c % a);
+    EXPECT_EQ(c, c / b * b + c % b);
+  }
+}
+
+TEST(correctness, pow) {
+  EXPECT_EQ(1, pow(big_integer(0), 0));
+  EXPECT_EQ(0, pow(big_integer(0), 7));
+  EXPECT_EQ(1, pow(big_integer(-1), 10));
+  EXPECT_EQ(-1, pow(big_integer(-1), 11));
+  EXPECT_EQ(-8, pow(big_integer(-2), 3));
+  EXPECT_EQ(big_integer(1) << 300, pow(big_integer(1) << 100, 3));
+  EXPECT_EQ(-(big_integer(3) << 100), pow(-(big_integer(3) << 100), 1));
+
+  big_integer long_base("-123456789012345678901");
+  for (big_integer base : {big_integer(10), big_integer(-6), big_integer(7) << 64, long_base}) {
+    big_integer expected = 1;
+    for (uint64_t exp = 0; exp < 70; ++exp) {
+      EXPECT_EQ(expected, pow(base, exp));
+      expected *= base;
+    }
+  }
+  EXPECT_EQ(big_integer("1" + std::string(2000, '0')), pow(big_integer(10), 2000));
+  EXPECT_THROW(pow(big_integer(3), std::numeric_limits<uint64_t>::max()), std::length_error);
+}
+
+TEST(correctness, limb_divisor) {
+  using limb = big_integer::limb;
+  EXPECT_THROW(limb_divisor(0), std::invalid_argument);
+
+  big_integer a = (big_integer(1) << 1000) / 3 + 12345;
+  for (limb d : {limb(1), limb(3), limb(10), limb(1000000000), limb(1) << 17, std::numeric_limits<limb>::max(),
+                 std::numeric_limits<limb>::max() / 2 + 1, std::numeric_limits<limb>::max() / 3}) {
+    limb_divisor divisor(d);
+    EXPECT_EQ(d, divisor.divisor());
+    for (const big_integer& x : {big_integer(0), big_integer(d - 1), a, -a, a * a}) {
+      EXPECT_EQ(x / big_integer(d), x / divisor);
+      EXPECT_EQ(x % big_integer(d), x % divisor);
+      big_integer y = x;
+      EXPECT_EQ(x / big_integer(d), y /= divisor);
+    }
+  }
+}
+
+TEST(correctness, powmod) {
+  EXPECT_EQ(24, powmod(2, 10, 1000));
+  EXPECT_EQ(6, powmod(-2, 3, 7));
+  EXPECT_EQ(1, powmod(-2, 0, 7));
+  EXPECT_EQ(0, powmod(5, 0, 1));
+  EXPECT_EQ(0, powmod(0, 5, 9));
+  EXPECT_EQ(1, powmod(3, (big_integer(1) << 127) - 2, (big_integer(1) << 127) - 1));
+  EXPECT_THROW(powmod(2, -1, 7), std::invalid_argument);
+  EXPECT_THROW(powmod(2, 3, 0), std::invalid_argument);
+  EXPECT_THROW(montgomery_context(10), std::invalid_argument);
+
+  montgomery_context ctx(7);
+  for (int e = 0; e < 20; ++e) {
+    EXPECT_EQ(powmod(3, e, 7), ctx.powmod(3, e));
+    EXPECT_EQ(powmod(3, e, 7), ctx.powmod_ct(3, e));
+  }
+}
+
+TEST(correctness, powmod_long) {
+  // 2^2203 - 1 is prime, so Fermat's little theorem holds for it.
+  big_integer p = (big_integer(1) << 2203) - 1;
+  montgomery_context ctx(p);
+  EXPECT_EQ(1, ctx.powmod(3, p - 1));
+  EXPECT_EQ(1, ctx.powmod_ct(3, p - 1));
+  EXPECT_EQ(p - 3, ctx.powmod(-3, p));
+  EXPECT_EQ(p - 1, ctx.powmod_ct(p - 1, 3));
+  EXPECT_EQ(0, ctx.powmod_ct(p, 3));
+  EXPECT_EQ(4, ctx.powmod_ct(p + 2, 2));
+
+  // The even modulus 2m takes the plain square-and-multiply path.
+  big_integer m = (big_integer(1) << 1500) / 7 | 1;
+  big_integer base = (big_integer(1) << 1700) / 11;
+  big_integer exp = (big_integer(1) << 900) / 13;
+  big_integer expected = powmod(base, exp, 2 * m) % m;
+  EXPECT_EQ(expected, powmod(base, exp, m));
+  EXPECT_EQ(expected, montgomery_context(m).powmod_ct(base, exp));
+}
+
+TEST(correctness, barrett_reducer) {
+  EXPECT_THROW(barrett_reducer(0), std::invalid_argument);
+  EXPECT_THROW(barrett_reducer(-5), std::invalid_argument);
+
+  // Powers of two have the largest reciprocal, all ones the smallest.
+  for (int bits : {1, 32, 64, 100, 1000, 20000}) {
+    big_integer power = big_integer(1) << bits;
+    for (big_integer m : {power, power - 1, power / 3 + 1}) {
+      barrett_reducer reducer(m);
+      big_integer a = (m << 3) / 5;
+      big_integer b = -(m >> 2) - 7;
+      for (big_integer x : {big_integer(0), a, b, a * a, b * b * b, a * b}) {
+        big_integer expected = x % m;
+        if (expected < 0) {
+          expected += m;
+        }
+        EXPECT_EQ(expected, reducer.reduce(x));
+      }
+      big_integer product = a * b % m;
+      EXPECT_EQ(product < 0 ? product + m : product, reducer.mulmod(a, b));
+      EXPECT_EQ(product * product % m, reducer.mulmod(a, a));
+    }
+  }
+}
+
+TEST(correctness, gcd) {
+  EXPECT_EQ(0, gcd(0, 0));
+  EXPECT_EQ(5, gcd(0, -5));
+  EXPECT_EQ(6, gcd(12, -18));
+  EXPECT_EQ(6, gcd(-18, -12));
+  EXPECT_EQ(0, lcm(0, 5));
+  EXPECT_EQ(12, lcm(-4, 6));
+  EXPECT_EQ(big_integer(1) << 200, gcd(big_integer(3) << 200, big_integer(1) << 300));
+
+  // Both operands are long enough for the half GCD, with either limb size.
+  big_integer common = pow(big_integer(7), 5000);
+  big_integer a = common * pow(big_integer(3), 30000);
+  big_integer b = -common * pow(big_integer(5), 20000) * 8;
+  EXPECT_EQ(common, gcd(a, b));
+  EXPECT_EQ(common, gcd(b, a));
+  EXPECT_EQ(a / common * -b, lcm(a, b));
+  EXPECT_EQ(1, gcd(a + 1, a));
+}
+
+TEST(correctness, extended_gcd) {
+  big_integer x, y;
+  EXPECT_EQ(0, extended_gcd(0, 0, x, y));
+  EXPECT_EQ(0, x);
+  EXPECT_EQ(0, y);
+  EXPECT_EQ(5, extended_gcd(-5, 0, x, y));
+  EXPECT_EQ(-1, x);
+  EXPECT_EQ(0, y);
+
+  big_integer common = pow(big_integer(7), 5000);
+  big_integer long_a = common * pow(big_integer(3), 30000);
+  big_integer long_b = common * pow(big_integer(5), 20000);
+  big_integer fib_prev = 0;
+  big_integer fib = 1;
+  std::vector<std::pair<big_integer, big_integer>> cases = {
+      {240, 46}, {-240, 46}, {46, -240}, {17, 17}, {long_a, -long_b}};
+  for (int i = 0; i < 3000; ++i) {
+    fib_prev = std::exchange(fib, fib + fib_prev);
+    if (i % 500 == 0) {
+      cases.emplace_back(fib, fib_prev);
+    }
+  }
+  for (auto& [a, b] : cases) {
+    big_integer g = gcd(a, b);
+    EXPECT_EQ(g, extended_gcd(a, b, x, y));
+    EXPECT_EQ(g, a * x + b * y);
+    if (a != b) {
+      EXPECT_LE(x * 2 * g, b < 0 ? -b : b);
+      EXPECT_GE(x * 2 * g, b < 0 ? b : -b);
+    }
+  }
+
+  // The coefficients may alias the operands.
+  big_integer a = 240, b = 46;
+  extended_gcd(a, b, a, b);
+  EXPECT_EQ(-9, a);
+  EXPECT_EQ(47, b);
+}
+
+TEST(correctness, invmod) {
+  EXPECT_EQ(5, invmod(3, 7));
+  EXPECT_EQ(2, invmod(-3, 7));
+  EXPECT_EQ(0, invmod(5, 1));
+  EXPECT_THROW(invmod(6, 9), std::invalid_argument);
+  EXPECT_THROW(invmod(3, 0), std::invalid_argument);
+  EXPECT_THROW(invmod(3, -7), std::invalid_argument);
+
+  big_integer mod = pow(big_integer(10), 1000);
+  big_integer a = pow(big_integer(3), 2000);
+  big_integer inverse = invmod(a, mod);
+  EXPECT_TRUE(inverse >= 0 && inverse < mod);
+  EXPECT_EQ(1, a * inverse % mod);
+  EXPECT_EQ(mod - inverse, invmod(-a, mod));
+}
+
 TEST(correctness, negation_long) {
   big_integer a("10000000000000000000000000000000000000000000000000000");
   big_integer c("-10000000000000000000000000000000000000000000000000000");
@@ -646,6 +1181,21 @@ TEST(correctness, shr_long) {
             big_integer("-3417856182746231874623148723164812376512852437523846123876") >> 31);
 }
 
+TEST(correctness, shr_long_signed) {
+  big_integer a = -(big_integer(1) << 640);
+
+  EXPECT_EQ(-(big_integer(1) << 576), a >> 64);
+  EXPECT_EQ(-(big_integer(1) << 576) - 1, (a - 1) >> 64);
+  EXPECT_EQ(-1, (a + 1) >> 640);
+  EXPECT_EQ(-1, (a + 1) >> 1000);
+  EXPECT_EQ(-(big_integer(1) << 608), (a + 1) >> 32);
+  EXPECT_EQ(a, ((a >> 100) << 100));
+  EXPECT_EQ(-2, a >> 639);
+  EXPECT_EQ(-1, a >> 640);
+  EXPECT_EQ(a - 1, (a - 1) >> 0);
+  EXPECT_EQ(0, big_integer() >> 0);
+}
+
 TEST(correctness, string_conv) {
   EXPECT_EQ("100", to_string(big_integer("100")));
   EXPECT_EQ("100", to_string(big_integer("0100")));
@@ -673,6 +1223,66 @@ void test_converting_ctor(T value) {
 }
 } // namespace
 
+TEST(correctness, string_conv_long) {
+  big_integer a = 1;
+  for (size_t i = 0; i < 3000; ++i) {
+    a *= 1000000000;
+  }
+  std::string zeroes(27000, '0');
+  EXPECT_EQ("1" + zeroes, to_string(a));
+  EXPECT_EQ("-" + std::string(27000, '9'), to_string(1 - a));
+  EXPECT_EQ("-" + std::string(26999, '9') + "8" + std::string(26999, '0') + "1", to_string((1 - a) * (a - 1)));
+}
+
+TEST(correctness, string_parse_long) {
+  std::string str(50000, '0');
+  for (size_t i = 0; i < str.size(); ++i) {
+    str[i] = static_cast<char>('0' + (i * 7 + i / 3) % 10);
+  }
+  str[0] = '-';
+  EXPECT_EQ(str, to_string(big_integer(str)));
+  big_integer power("1" + std::string(15000, '0'));
+  EXPECT_EQ(big_integer("1" + std::string(30000, '0')), power * power);
+}
+
+TEST(correctness, from_chars) {
+  std::string_view str = "-000123456789012345678901234567890 tail";
+  big_integer a = 1;
+  auto [ptr, ec] = from_chars(str.data(), str.data() + str.size(), a);
+  EXPECT_EQ(ec, std::errc());
+  EXPECT_EQ(ptr, str.data() + str.find(' '));
+  EXPECT_EQ(a, big_integer("-123456789012345678901234567890"));
+
+  auto result = from_chars(ptr, str.data() + str.size(), a);
+  EXPECT_EQ(result.ec, std::errc::invalid_argument);
+  EXPECT_EQ(result.ptr, ptr);
+  EXPECT_EQ(a, big_integer("-123456789012345678901234567890"));
+}
+
+TEST(correctness, string_conv_radix) {
+  big_integer a("-123456789012345678901234567890");
+  EXPECT_EQ("-18ee90ff6c373e0ee4e3f0ad2", to_string(a, 16));
+  EXPECT_EQ("-1111111111111111111111111111111", to_string(big_integer((1LL << 31) - 1) * -1, 2));
+  EXPECT_EQ("-byw97um9s91dlz68tsi", to_string(a, 36));
+  EXPECT_EQ("0", to_string(big_integer(), 7));
+  EXPECT_EQ(a, big_integer("-18EE90FF6C373E0EE4E3F0AD2", 16));
+  EXPECT_EQ(a, big_integer("-byw97um9s91dlz68tsi", 36));
+  EXPECT_THROW(big_integer("12", 2), std::invalid_argument);
+  EXPECT_THROW(to_string(a, 37), std::invalid_argument);
+
+  big_integer b = (big_integer(1) << 10000) - 1;
+  EXPECT_EQ(std::string(2500, 'f'), to_string(b, 16));
+  EXPECT_EQ(b, big_integer(std::string(10000, '1'), 2));
+  EXPECT_EQ(b, big_integer(to_string(b, 3), 3));
+}
+
+TEST(correctness, stream_radix) {
+  std::ostringstream out;
+  out << std::hex << big_integer(-255) << ' ' << std::showbase << std::uppercase << big_integer(-255) << ' '
+      << std::oct << big_integer(8) << ' ' << std::dec << big_integer(-8);
+  EXPECT_EQ("-ff -0XFF 010 -8", out.str());
+}
+
 TEST(correctness, converting_ctor) {
   using std::numeric_limits;
 